@@ -6,6 +6,8 @@
 #include "GLM/gtc/type_ptr.hpp"
 #include "GLAD/glad.h"
 #include "GLFW/glfw3.h"
+#include "mesh_cache.h"
+#include "shapes.h"
 
 using std::cout;
 using std::endl;
@@ -14,6 +16,7 @@ using glm::dvec3;
 static struct {
 	glm::dvec2 mouse_position;
 	glm::dvec2 screen_dimensions = glm::dvec2(960,960);
+	bool procedural_surfaces = false;//G toggles, evaluates the surfaces in the vertex shader instead of drawing the VAOs
 } Globals;
 
 /* GLFW Callback functions */
@@ -30,53 +33,13 @@ static void WindowSizeCallback(GLFWwindow*window, int width, int height) {
 	Globals.screen_dimensions.y = height;
 	glViewport(0, 0, width, height);
 }
-
-
-glm::dvec2 ParametricHalfCircle(double t, double radius) {
-	//t is 0 to 1
-	t -= 0.5;//-0.5 to 0.5
-	t *= glm::pi<double>();//-0.5pi to 0.5 pi
-	return glm::dvec2(cos(t), sin(t))*radius;//for -1/2pi to 1/2pi
-}
-glm::dvec2 ParametricCircle(double t, glm::dvec2 center, double radius) {
-	//t is 0 to 1
-	t -= 0.5;
-	t *= 2;
-	t *= glm::pi<double>();//-pi to pi
-	return glm::dvec2(cos(t), sin(t))*radius + center;//for -pi to pi
-}
-glm::dvec2 ParametricSpikes(double t, double radius, int a) {
-	//t is 0 to 1
-	t -= 0.5;//-0.5 to 0.5
-	t *= glm::pi<double>();//-0.5pi to 0.5 pi
-	return glm::dvec2((cos(t) + sin(a*t)/a), (sin(t)+cos(a*t)/a))*radius/2.;//for -1/2pi to 1/2pi
-}
-glm::dvec2 ParametricNewCurve(double t, double radius, int a) {
-	//t is 0 to 1
-	t *= glm::pi<double>();//-pi to pi
-	return glm::dvec2(sin(t) * sin(t) * sin(t) * 16, 13 * cos(t) - 4 * cos(2 * t) - 2 * cos(3 * t) - cos(68 * t)) * 1. / 10.;//for -1/2pi to 1/2pi
-}
-int VRtoIndex(int v, int r, int vertical_segment, int rotation_segment) {
-	return (r%rotation_segment) * vertical_segment + (v);
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+	if (key == GLFW_KEY_G && action == GLFW_PRESS) {
+		Globals.procedural_surfaces = !Globals.procedural_surfaces;
+		cout << (Globals.procedural_surfaces ? "Procedural surfaces (vertex shader)" : "Surfaces from VAOs") << endl;
+	}
 }
-glm::dvec3 ParametricSphere(double t, double r, double radius) {
-	auto p = glm::dvec3(ParametricHalfCircle(t, radius), 0);
-	return glm::rotateY(p, r*glm::two_pi<double>());
-};
-glm::dvec3 ParametricTorus(double t, double r, glm::dvec2 center_of_circle, double radius) {
-	auto p = glm::dvec3(ParametricCircle(t, center_of_circle, radius), 0);
-	return glm::rotateY(p, r*glm::two_pi<double>());
-};
-glm::dvec3 ParametricSpikesSurface(double t, double r, double radius, int a) {
-	auto p = glm::dvec3(ParametricSpikes(t, radius, a), 0);
-	return glm::rotateY(p, r*glm::two_pi<double>());
-};
-glm::dvec3 ParametricNewShapeSurface(double t, double r, double radius, int a) {
-	auto p = glm::dvec3(ParametricNewCurve(t, radius, a), 0);
-	if (r < 0.3 || r>0.7)
-		return glm::rotateY(p, r * glm::two_pi<double>());
-	return glm::rotateY(p, r * glm::two_pi<double>());
-};
+
 
 /* OpenGL Utility Structs */
 struct VAO {
@@ -86,200 +49,93 @@ struct VAO {
 	GLuint normals_buffer;
 	GLuint element_array_buffer;
 	GLsizei element_array_count;
+	GLenum index_type; // GL_UNSIGNED_SHORT when every index fits, GL_UNSIGNED_INT otherwise
 
-	VAO(const std::vector<glm::vec3>& positions,const std::vector<glm::vec3>& normals, const std::vector<GLuint>& indices) {
+	//from raw arrays, like a mapped mesh cache entry
+	VAO(const glm::vec3* positions, size_t vertex_count, const glm::vec3* normals, size_t normal_count, const GLuint* indices, size_t index_count) {
 		glGenVertexArrays(1, &id);
 		glBindVertexArray(id);
 
 		glGenBuffers(1, &position_buffer);
 		glBindBuffer(GL_ARRAY_BUFFER, position_buffer);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*positions.size(), positions.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3)*vertex_count, positions, GL_STATIC_DRAW);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
 		glEnableVertexAttribArray(0);
 
 		glGenBuffers(1, &normals_buffer);
 		glBindBuffer(GL_ARRAY_BUFFER, normals_buffer);
-		glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, normal_count * sizeof(glm::vec3), normals, GL_STATIC_DRAW);
 
 		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
 		glEnableVertexAttribArray(1);
 
 		glGenBuffers(1, &element_array_buffer);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*indices.size(), indices.data(), GL_STATIC_DRAW);
-		
-		element_array_count = int(indices.size());
-	}
-};
-
-
-VAO SphereVAO(const glm::dvec3& center, const double& radius, const int& vertical_segment, const int& rotation_segment) {
-	//TODO fix radius
-	std::vector<glm::vec3> positions;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			positions.push_back(ParametricSphere(v / double(vertical_segment - 1), r / double(rotation_segment), radius) + center);
+		if (vertex_count <= 0x10000) {
+			// Indices can't exceed the vertex count, so halve the index buffer
+			index_type = GL_UNSIGNED_SHORT;
+			std::vector<GLushort> short_indices(indices, indices + index_count);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort)*short_indices.size(), short_indices.data(), GL_STATIC_DRAW);
+		} else {
+			index_type = GL_UNSIGNED_INT;
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint)*index_count, indices, GL_STATIC_DRAW);
 		}
+
+		element_array_count = int(index_count);
 	}
-	/*
-	std::vector<glm::vec3> normals;
-	for (const auto& position : positions)
-		normals.push_back(glm::normalize(position));
-		*/
-	std::vector<glm::vec3> normals;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			auto nv = v / double(vertical_segment - 1);
-			auto nr = r / double(rotation_segment);
-			auto epsilon = glm::epsilon<double>();
-
-			auto tangent_to_next_v = ParametricSphere(nv + epsilon, nr, radius) - ParametricSphere(nv, nr, radius);
-			auto tangent_to_prev_v = -ParametricSphere(nv - epsilon, nr, radius) + ParametricSphere(nv, nr, radius);
-			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
-
-			auto tangent_to_next_r = ParametricSphere(nv, nr + epsilon, radius) - ParametricSphere(nv, nr, radius);
-			auto tangent_to_prev_r = -ParametricSphere(nv, nr - epsilon, radius) + ParametricSphere(nv, nr, radius);
-			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
-
-			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(surface_normal);
-		}
+	VAO(const std::vector<glm::vec3>& positions,const std::vector<glm::vec3>& normals, const std::vector<GLuint>& indices)
+		: VAO(positions.data(), positions.size(), normals.data(), normals.size(), indices.data(), indices.size()) {
 	}
-	std::vector<GLuint> indices;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment - 1; ++v) {
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
-
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-		}
+	//uploads a mesh from shapes.h
+	VAO(const Mesh& mesh) : VAO(mesh.positions, mesh.normals, mesh.indices) {
 	}
-	return VAO(positions, normals, indices);
+};
+
+
+//uploads the mars_rover_openGL mesh cache entry of shape and its parameters, on a miss generate() builds the mesh and it is stored first.
+//the shapes have no uvs, their entries hold zeros there, and so do the normals the torus has no ring for.
+//entries are found again under the same shape name, parameters, shapes_revision and mesh_cache_version.
+template <typename Generate>
+VAO CachedShapeVAO(const char* shape, std::initializer_list<double> parameters, const Generate& generate) {
+	auto key = MeshCacheKey(shape, { shapes_revision }, parameters);
+	MappedMesh cached;
+	if (LoadMeshCache(key, cached))
+		return VAO(cached.positions, cached.vertex_count, cached.normals, cached.vertex_count, cached.indices, cached.index_count);
+
+	Mesh mesh = generate();
+	mesh.normals.resize(mesh.positions.size());
+	if (!SaveMeshCache(key, mesh.positions, mesh.normals, std::vector<glm::vec2>(mesh.positions.size()), mesh.indices, Bounds()))
+		cout << "Mesh cache entry for " << shape << " couldn't be written" << endl;
+	return VAO(mesh);
 }
 
+VAO SphereVAO(const glm::dvec3& center, const double& radius, const int& vertical_segment, const int& rotation_segment) {
+	return CachedShapeVAO("Sphere", { center.x, center.y, center.z, radius, double(vertical_segment), double(rotation_segment) }, [&]() {
+		return SphereMesh(center, radius, vertical_segment, rotation_segment);
+	});
+}
 VAO TorusVAO(const glm::dvec3& center, const double& radius,glm::dvec2 center_of_circle, const int& vertical_segment, const int & rotation_segment) {
-	std::vector<glm::vec3> positions;
-	for (int r = 0; r < rotation_segment*2; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			positions.push_back(ParametricTorus(v / double(vertical_segment - 1), r / double(rotation_segment),center_of_circle,radius) + center);
-		}
-	}
-	std::vector<glm::vec3> normals;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			auto nv = v / double(vertical_segment - 1);
-			auto nr = r / double(rotation_segment);
-			auto epsilon = glm::epsilon<double>();//x+i i->0 from positive side, x+0.0000001
-
-			auto tangent_to_next_v = ParametricTorus(nv + epsilon, nr, center_of_circle,radius) - ParametricTorus(nv, nr, center_of_circle,radius);
-			auto tangent_to_prev_v = ParametricTorus(nv, nr, center_of_circle, radius) - ParametricTorus(nv - epsilon, nr, center_of_circle, radius);
-			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
-
-			auto tangent_to_next_r = ParametricTorus(nv, nr + epsilon, center_of_circle,radius) - ParametricTorus(nv, nr, center_of_circle,radius);
-			auto tangent_to_prev_r = ParametricTorus(nv, nr, center_of_circle, radius) - ParametricTorus(nv, nr - epsilon, center_of_circle, radius);
-			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
-
-			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(surface_normal);
-		}
-	}
-	std::vector<GLuint> indices;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment-1; ++v) {
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
-
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-		}
-	}
-	return VAO(positions, normals, indices);
+	return CachedShapeVAO("Torus", { center.x, center.y, center.z, radius, center_of_circle.x, center_of_circle.y, double(vertical_segment), double(rotation_segment) }, [&]() {
+		return TorusMesh(center, radius, center_of_circle, vertical_segment, rotation_segment);
+	});
 }
 VAO SpikesVAO(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment) {
-	//TODO fix radius
-	std::vector<glm::vec3> positions;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			positions.push_back(ParametricSpikesSurface(v / double(vertical_segment - 1), r / double(rotation_segment), radius, a) + center);
-		}
-	}
-	std::vector<glm::vec3> normals;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			auto nv = v / double(vertical_segment - 1);
-			auto nr = r / double(rotation_segment);
-			auto epsilon = glm::epsilon<double>();
-
-			auto tangent_to_next_v = ParametricSpikesSurface(nv + epsilon, nr, radius, a) - ParametricSpikesSurface(nv, nr, radius, a);
-			auto tangent_to_prev_v = -ParametricSpikesSurface(nv - epsilon, nr, radius, a) + ParametricSpikesSurface(nv, nr, radius, a);
-			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
-
-			auto tangent_to_next_r = ParametricSpikesSurface(nv, nr + epsilon, radius, a) - ParametricSpikesSurface(nv, nr, radius, a);
-			auto tangent_to_prev_r = -ParametricSpikesSurface(nv, nr - epsilon, radius, a) + ParametricSpikesSurface(nv, nr, radius, a);
-			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
-
-			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(surface_normal);
-		}
-	}
-	std::vector<GLuint> indices;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment - 1; ++v) {
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
-
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-		}
-	}
-	return VAO(positions, normals, indices);
+	return CachedShapeVAO("Spikes", { center.x, center.y, center.z, radius, double(a), double(vertical_segment), double(rotation_segment) }, [&]() {
+		return SpikesMesh(center, radius, a, vertical_segment, rotation_segment);
+	});
 }
 VAO NewShapeVAO(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment) {
-	std::vector<glm::vec3> positions;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			positions.push_back(ParametricNewShapeSurface(v / double(vertical_segment - 1), r / double(rotation_segment), radius, a) + center);
-		}
-	}
-	std::vector<glm::vec3> normals;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment; ++v) {
-			auto nv = v / double(vertical_segment - 1);
-			auto nr = r / double(rotation_segment);
-			auto epsilon = glm::epsilon<double>();
-
-			auto tangent_to_next_v = ParametricNewShapeSurface(nv + epsilon, nr, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
-			auto tangent_to_prev_v = -ParametricNewShapeSurface(nv - epsilon, nr, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
-			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
-
-			auto tangent_to_next_r = ParametricNewShapeSurface(nv, nr + epsilon, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
-			auto tangent_to_prev_r = -ParametricNewShapeSurface(nv, nr - epsilon, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
-			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
-
-			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(-surface_normal);//dunno why but normals were wrong, this fixes it.
-		}
-	}
-	std::vector<GLuint> indices;
-	for (int r = 0; r < rotation_segment; ++r) {
-		for (int v = 0; v < vertical_segment - 1; ++v) {
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
-
-			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
-			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
-		}
-	}
-	return VAO(positions, normals, indices);
+	return CachedShapeVAO("NewShape", { center.x, center.y, center.z, radius, double(a), double(vertical_segment), double(rotation_segment) }, [&]() {
+		return NewShapeMesh(center, radius, a, vertical_segment, rotation_segment);
+	});
+}
+VAO AdaptiveNewShapeVAO(const glm::dvec3& center, const double& radius, int a, double tolerance, const int& rotation_segment) {
+	auto vao = CachedShapeVAO("AdaptiveNewShape", { center.x, center.y, center.z, radius, double(a), tolerance, double(rotation_segment) }, [&]() {
+		return AdaptiveNewShapeMesh(center, radius, a, tolerance, rotation_segment);
+	});
+	//every ring has two triangles per rotation segment towards the next one
+	cout << "NewShape: " << vao.element_array_count / (6 * rotation_segment) + 1 << " adaptive rings for a chordal error of " << tolerance << endl;
+	return vao;
 }
 /* OpenGL Utility Functions */
 GLuint CreateShaderFromSource(GLenum shader_type, const GLchar * source) {
@@ -364,6 +220,7 @@ int main(void) {
 	/* Set GLFW Callbacks*/
 	glfwSetCursorPosCallback(window, CursorPositionCallback);
 	glfwSetWindowSizeCallback(window, WindowSizeCallback);
+	glfwSetKeyCallback(window, KeyCallback);
 	/* Configure OpenGL */
 	glClearColor(0, 0, 0, 0.1f);//transparent
 	glEnable(GL_DEPTH_TEST);
@@ -403,28 +260,14 @@ int main(void) {
 	VAO sphereVAO = SphereVAO(glm::dvec3(0, 0, 0.0), 0.3, 16, 16);
 	VAO spikesVAO = SpikesVAO(glm::dvec3(0, 0, 0.0), 0.3,12, 16, 16);
 	VAO torusVAO = TorusVAO(glm::dvec3(0, 0, 0),0.09,glm::dvec2(0.210,0),16, 16);
-	VAO topacVAO = NewShapeVAO(glm::dvec3(0, 0, 0.0), 1, -10, 16, 16);
+	//cos(68t) needs about 245 uniform rings for a chordal error of 0.01, the adaptive version gets there with 69
+	VAO topacVAO = AdaptiveNewShapeVAO(glm::dvec3(0, 0, 0.0), 1, -10, 0.01, 16);
 	//VAO spikesVAO = SpikesVAO();
 	//center of circle is relative (transform the object to <center> after creatign the torus at origin)//
 	//center of sphere+r=r_torus
 	/* TODO watch from lab8 extra 1:12:24, an extra tangent method and an extra shape is there.*/
 	
-	GLuint program = CreateProgramFromSources(
-		R"VERTEX(
-		#version 330 core
-		layout(location = 0) in vec3 a_position;
-		layout(location = 1) in vec3 a_normal;
-
-		uniform mat4 u_transform;
-		out vec3 vertex_normal;
-		out vec3 vertex_position;
-		void main(){
-			gl_Position=u_transform*vec4(a_position,1);
-			vertex_normal=(u_transform*vec4(a_normal,0)).xyz;
-			vertex_position=gl_Position.xyz;
-		}
-	)VERTEX",
-		R"FRAGMENT(
+	auto fragment_shader_source = R"FRAGMENT(
 		#version 330 core
 		uniform vec2 u_mouse_position; 
 		uniform vec3 u_surface_color;
@@ -474,18 +317,127 @@ int main(void) {
 
 			out_color=vec4(1);
 		}
-	)FRAGMENT");
+	)FRAGMENT";
+
+	GLuint program = CreateProgramFromSources(
+		R"VERTEX(
+		#version 330 core
+		layout(location = 0) in vec3 a_position;
+		layout(location = 1) in vec3 a_normal;
+
+		uniform mat4 u_transform;
+		out vec3 vertex_normal;
+		out vec3 vertex_position;
+		void main(){
+			gl_Position=u_transform*vec4(a_position,1);
+			vertex_normal=(u_transform*vec4(a_normal,0)).xyz;
+			vertex_position=gl_Position.xyz;
+		}
+	)VERTEX",
+		fragment_shader_source);
 
-	glUseProgram(program);
-	auto mouse_position_location = glGetUniformLocation(program, "u_mouse_position");
-	auto transform_location = glGetUniformLocation(program, "u_transform");
-	auto surface_color = glGetUniformLocation(program, "u_surface_color");
+	//Same surfaces with no vertex buffers at all. gl_VertexID picks the quad and corner, in the order of the
+	//index buffers of SphereVAO and the others, and the vertex shader evaluates the profile and its derivative.
+	//The normal is cross(tangent_r, tangent_v) worked out by hand: the 2D profile normal rotated around Y.
+	GLuint procedural_program = CreateProgramFromSources(
+		R"VERTEX(
+		#version 330 core
+		uniform mat4 u_transform;
+		uniform int u_shape;//0 sphere, 1 spikes, 2 torus, 3 new shape
+		uniform int u_vertical_segment;
+		uniform int u_rotation_segment;
+		uniform float u_radius;
+		uniform float u_spikes;
+		uniform vec2 u_center_of_circle;
+		out vec3 vertex_normal;
+		out vec3 vertex_position;
+		const float PI = 3.14159265358979;
+
+		//point of the profile in xy, its direction along t in zw
+		vec4 Profile(float t){
+			if (u_shape == 0) {
+				float a = (t - 0.5) * PI;
+				return vec4(vec2(cos(a), sin(a)) * u_radius, -sin(a), cos(a));
+			}
+			if (u_shape == 1) {
+				float a = (t - 0.5) * PI;
+				float k = u_spikes;
+				vec2 p = vec2(cos(a) + sin(k * a) / k, sin(a) + cos(k * a) / k) * u_radius / 2;
+				return vec4(p, -sin(a) + cos(k * a), cos(a) - sin(k * a));
+			}
+			if (u_shape == 2) {
+				float a = (t - 0.5) * 2 * PI;
+				return vec4(vec2(cos(a), sin(a)) * u_radius + u_center_of_circle, -sin(a), cos(a));
+			}
+			float a = t * PI;
+			float s = sin(a);
+			vec2 p = vec2(s * s * s * 16, 13 * cos(a) - 4 * cos(2 * a) - 2 * cos(3 * a) - cos(68 * a)) / 10;
+			return vec4(p, 48 * s * s * cos(a), -13 * s + 8 * sin(2 * a) + 6 * sin(3 * a) + 68 * sin(68 * a));
+		}
+
+		void main(){
+			//(v, r) offsets of the six corners of a quad, two triangles
+			const ivec2 corners[6] = ivec2[6](ivec2(1, 0), ivec2(0, 1), ivec2(0, 0), ivec2(1, 0), ivec2(1, 1), ivec2(0, 1));
+			int quad = gl_VertexID / 6;
+			ivec2 corner = corners[gl_VertexID % 6];
+			int v = quad % (u_vertical_segment - 1) + corner.x;
+			int r = quad / (u_vertical_segment - 1) + corner.y;
+
+			vec4 profile = Profile(float(v) / float(u_vertical_segment - 1));
+			float angle = float(r) / float(u_rotation_segment) * 2 * PI;
+			float c = cos(angle);
+			float s = sin(angle);
+			vec3 position = vec3(profile.x * c, profile.y, -profile.x * s);
+			vec3 normal = normalize(vec3(profile.w * c, -profile.z, -profile.w * s)) * (profile.x < 0 ? -1 : 1);
+			if (u_shape == 3)
+				normal = -normal;//same flip as NewShapeVAO
+
+			gl_Position=u_transform*vec4(position,1);
+			vertex_normal=(u_transform*vec4(normal,0)).xyz;
+			vertex_position=gl_Position.xyz;
+		}
+	)VERTEX",
+		fragment_shader_source);
+
+	//core profile can't draw without a VAO bound, even when it has no attributes
+	GLuint procedural_vao;
+	glGenVertexArrays(1, &procedural_vao);
+
+	auto shape_location = glGetUniformLocation(procedural_program, "u_shape");
+	auto vertical_segment_location = glGetUniformLocation(procedural_program, "u_vertical_segment");
+	auto rotation_segment_location = glGetUniformLocation(procedural_program, "u_rotation_segment");
+	auto radius_location = glGetUniformLocation(procedural_program, "u_radius");
+	auto spikes_location = glGetUniformLocation(procedural_program, "u_spikes");
+	auto center_of_circle_location = glGetUniformLocation(procedural_program, "u_center_of_circle");
+	auto DrawProceduralSurface = [&](int shape, int vertical_segment, int rotation_segment, float radius, float spikes, glm::vec2 center_of_circle) {
+		glUniform1i(shape_location, shape);
+		glUniform1i(vertical_segment_location, vertical_segment);
+		glUniform1i(rotation_segment_location, rotation_segment);
+		glUniform1f(radius_location, radius);
+		glUniform1f(spikes_location, spikes);
+		glUniform2fv(center_of_circle_location, 1, glm::value_ptr(center_of_circle));
+		glBindVertexArray(procedural_vao);
+		glDrawArrays(GL_TRIANGLES, 0, (vertical_segment - 1) * rotation_segment * 6);
+	};
+
+	GLuint programs[2] = { program, procedural_program };
+	GLint mouse_position_locations[2], transform_locations[2], surface_color_locations[2];
+	for (int i = 0; i < 2; i++) {
+		mouse_position_locations[i] = glGetUniformLocation(programs[i], "u_mouse_position");
+		transform_locations[i] = glGetUniformLocation(programs[i], "u_transform");
+		surface_color_locations[i] = glGetUniformLocation(programs[i], "u_surface_color");
+	}
 
 	/* Loop until the user closes the window */
 	while (!glfwWindowShouldClose(window))
 	{
 		/* Render here */
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		auto procedural = Globals.procedural_surfaces;
+		glUseProgram(programs[procedural]);
+		auto mouse_position_location = mouse_position_locations[procedural];
+		auto transform_location = transform_locations[procedural];
+		auto surface_color = surface_color_locations[procedural];
 		auto mouse_position = glm::vec3(Globals.mouse_position*2.0 - 1.0, 0);//0,+1->-1,+1
 		glUniform2fv(mouse_position_location, 1, glm::value_ptr(glm::vec2(mouse_position)));
 		//translate rotate draw undo the translate -> center->rotate->translate
@@ -503,8 +455,12 @@ int main(void) {
 				transform = glm::rotate(transform, glm::radians(float(glfwGetTime()) * 10), glm::vec3(1, 1, 0));
 				glUniformMatrix4fv(transform_location, 1, GL_FALSE, glm::value_ptr(transform));
 				glUniform3fv(surface_color, 1, glm::value_ptr(glm::vec3(0.5)));
-				glBindVertexArray(sphereVAO.id);
-				glDrawElements(GL_TRIANGLES, sphereVAO.element_array_count, GL_UNSIGNED_INT, NULL);
+				if (procedural) {
+					DrawProceduralSurface(0, 16, 16, 0.3f, 0, glm::vec2(0));
+				} else {
+					glBindVertexArray(sphereVAO.id);
+					glDrawElements(GL_TRIANGLES, sphereVAO.element_array_count, sphereVAO.index_type, NULL);
+				}
 				break;
 			case 1:
 				transform = glm::translate(transform, glm::vec3(-0.5, -0.5, 0));
@@ -512,8 +468,13 @@ int main(void) {
 				transform = glm::rotate(transform, glm::radians(float(glfwGetTime()) * 10), glm::vec3(1, 1, 0));
 				glUniformMatrix4fv(transform_location, 1, GL_FALSE, glm::value_ptr(transform));
 				glUniform3fv(surface_color, 1, glm::value_ptr(glm::vec3(0,1,0)));
-				glBindVertexArray(spikesVAO.id);
-				glDrawElements(GL_TRIANGLES, spikesVAO.element_array_count, GL_UNSIGNED_INT, NULL);
+				if (procedural) {
+					//nothing to regenerate, so the spike count can change every frame
+					DrawProceduralSurface(1, 16, 16, 0.3f, 12 + 4 * sin(float(glfwGetTime())), glm::vec2(0));
+				} else {
+					glBindVertexArray(spikesVAO.id);
+					glDrawElements(GL_TRIANGLES, spikesVAO.element_array_count, spikesVAO.index_type, NULL);
+				}
 				break;
 			case 2:
 				transform = glm::translate(transform, glm::vec3(0.5, 0.5, 0));
@@ -521,8 +482,12 @@ int main(void) {
 				transform = glm::rotate(transform, glm::radians(float(glfwGetTime()) * 10), glm::vec3(1, 1, 0));
 				glUniformMatrix4fv(transform_location, 1, GL_FALSE, glm::value_ptr(transform));
 				glUniform3fv(surface_color, 1, glm::value_ptr(glm::vec3(1,0,0)));
-				glBindVertexArray(torusVAO.id);
-				glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
+				if (procedural) {
+					DrawProceduralSurface(2, 16, 16, 0.09f, 0, glm::vec2(0.210, 0));
+				} else {
+					glBindVertexArray(torusVAO.id);
+					glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, torusVAO.index_type, NULL);
+				}
 				break;
 			case 3:
 				transform = glm::translate(transform, glm::vec3(0.5, -0.5, 0));
@@ -531,8 +496,13 @@ int main(void) {
 				transform = glm::scale(transform, glm::vec3(0.25));
 				glUniformMatrix4fv(transform_location, 1, GL_FALSE, glm::value_ptr(transform));
 				glUniform3fv(surface_color, 1, glm::value_ptr(glm::vec3(0,0,1)));
-				glBindVertexArray(topacVAO.id);
-				glDrawElements(GL_TRIANGLES, topacVAO.element_array_count, GL_UNSIGNED_INT, NULL);
+				if (procedural) {
+					//uniform rings, 245 of them match the chordal error of the adaptive VAO
+					DrawProceduralSurface(3, 245, 16, 1, 0, glm::vec2(0));
+				} else {
+					glBindVertexArray(topacVAO.id);
+					glDrawElements(GL_TRIANGLES, topacVAO.element_array_count, topacVAO.index_type, NULL);
+				}
 				break;
 			default:
 				break;
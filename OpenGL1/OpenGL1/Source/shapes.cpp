@@ -0,0 +1,266 @@
+#include "shapes.h"
+
+#include <utility>
+#include "GLM/gtc/constants.hpp"
+#include "GLM/gtx/rotate_vector.hpp"
+#include "adaptive_sampling.h"
+
+glm::dvec2 ParametricHalfCircle(double t, double radius) {
+	//t is 0 to 1
+	t -= 0.5;//-0.5 to 0.5
+	t *= glm::pi<double>();//-0.5pi to 0.5 pi
+	return glm::dvec2(cos(t), sin(t))*radius;//for -1/2pi to 1/2pi
+}
+glm::dvec2 ParametricCircle(double t, glm::dvec2 center, double radius) {
+	//t is 0 to 1
+	t -= 0.5;
+	t *= 2;
+	t *= glm::pi<double>();//-pi to pi
+	return glm::dvec2(cos(t), sin(t))*radius + center;//for -pi to pi
+}
+glm::dvec2 ParametricSpikes(double t, double radius, int a) {
+	//t is 0 to 1
+	t -= 0.5;//-0.5 to 0.5
+	t *= glm::pi<double>();//-0.5pi to 0.5 pi
+	return glm::dvec2((cos(t) + sin(a*t)/a), (sin(t)+cos(a*t)/a))*radius/2.;//for -1/2pi to 1/2pi
+}
+glm::dvec2 ParametricNewCurve(double t, double radius, int a) {
+	//t is 0 to 1
+	t *= glm::pi<double>();//-pi to pi
+	return glm::dvec2(sin(t) * sin(t) * sin(t) * 16, 13 * cos(t) - 4 * cos(2 * t) - 2 * cos(3 * t) - cos(68 * t)) * 1. / 10.;//for -1/2pi to 1/2pi
+}
+int VRtoIndex(int v, int r, int vertical_segment, int rotation_segment) {
+	return (r%rotation_segment) * vertical_segment + (v);
+}
+glm::dvec3 ParametricSphere(double t, double r, double radius) {
+	auto p = glm::dvec3(ParametricHalfCircle(t, radius), 0);
+	return glm::rotateY(p, r*glm::two_pi<double>());
+};
+glm::dvec3 ParametricTorus(double t, double r, glm::dvec2 center_of_circle, double radius) {
+	auto p = glm::dvec3(ParametricCircle(t, center_of_circle, radius), 0);
+	return glm::rotateY(p, r*glm::two_pi<double>());
+};
+glm::dvec3 ParametricSpikesSurface(double t, double r, double radius, int a) {
+	auto p = glm::dvec3(ParametricSpikes(t, radius, a), 0);
+	return glm::rotateY(p, r*glm::two_pi<double>());
+};
+glm::dvec3 ParametricNewShapeSurface(double t, double r, double radius, int a) {
+	auto p = glm::dvec3(ParametricNewCurve(t, radius, a), 0);
+	if (r < 0.3 || r>0.7)
+		return glm::rotateY(p, r * glm::two_pi<double>());
+	return glm::rotateY(p, r * glm::two_pi<double>());
+};
+
+Mesh SphereMesh(const glm::dvec3& center, const double& radius, const int& vertical_segment, const int& rotation_segment) {
+	//TODO fix radius
+	std::vector<glm::vec3> positions;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			positions.push_back(ParametricSphere(v / double(vertical_segment - 1), r / double(rotation_segment), radius) + center);
+		}
+	}
+	/*
+	std::vector<glm::vec3> normals;
+	for (const auto& position : positions)
+		normals.push_back(glm::normalize(position));
+		*/
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			auto nv = v / double(vertical_segment - 1);
+			auto nr = r / double(rotation_segment);
+			auto epsilon = glm::epsilon<double>();
+
+			auto tangent_to_next_v = ParametricSphere(nv + epsilon, nr, radius) - ParametricSphere(nv, nr, radius);
+			auto tangent_to_prev_v = -ParametricSphere(nv - epsilon, nr, radius) + ParametricSphere(nv, nr, radius);
+			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
+
+			auto tangent_to_next_r = ParametricSphere(nv, nr + epsilon, radius) - ParametricSphere(nv, nr, radius);
+			auto tangent_to_prev_r = -ParametricSphere(nv, nr - epsilon, radius) + ParametricSphere(nv, nr, radius);
+			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
+
+			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
+			normals.push_back(surface_normal);
+		}
+	}
+	std::vector<GLuint> indices;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment - 1; ++v) {
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
+
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+		}
+	}
+	return Mesh{ std::move(positions), std::move(normals), std::move(indices) };
+}
+
+Mesh TorusMesh(const glm::dvec3& center, const double& radius,glm::dvec2 center_of_circle, const int& vertical_segment, const int & rotation_segment) {
+	std::vector<glm::vec3> positions;
+	for (int r = 0; r < rotation_segment*2; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			positions.push_back(ParametricTorus(v / double(vertical_segment - 1), r / double(rotation_segment),center_of_circle,radius) + center);
+		}
+	}
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			auto nv = v / double(vertical_segment - 1);
+			auto nr = r / double(rotation_segment);
+			auto epsilon = glm::epsilon<double>();//x+i i->0 from positive side, x+0.0000001
+
+			auto tangent_to_next_v = ParametricTorus(nv + epsilon, nr, center_of_circle,radius) - ParametricTorus(nv, nr, center_of_circle,radius);
+			auto tangent_to_prev_v = ParametricTorus(nv, nr, center_of_circle, radius) - ParametricTorus(nv - epsilon, nr, center_of_circle, radius);
+			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
+
+			auto tangent_to_next_r = ParametricTorus(nv, nr + epsilon, center_of_circle,radius) - ParametricTorus(nv, nr, center_of_circle,radius);
+			auto tangent_to_prev_r = ParametricTorus(nv, nr, center_of_circle, radius) - ParametricTorus(nv, nr - epsilon, center_of_circle, radius);
+			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
+
+			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
+			normals.push_back(surface_normal);
+		}
+	}
+	std::vector<GLuint> indices;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment-1; ++v) {
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
+
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+		}
+	}
+	return Mesh{ std::move(positions), std::move(normals), std::move(indices) };
+}
+Mesh SpikesMesh(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment) {
+	//TODO fix radius
+	std::vector<glm::vec3> positions;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			positions.push_back(ParametricSpikesSurface(v / double(vertical_segment - 1), r / double(rotation_segment), radius, a) + center);
+		}
+	}
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			auto nv = v / double(vertical_segment - 1);
+			auto nr = r / double(rotation_segment);
+			auto epsilon = glm::epsilon<double>();
+
+			auto tangent_to_next_v = ParametricSpikesSurface(nv + epsilon, nr, radius, a) - ParametricSpikesSurface(nv, nr, radius, a);
+			auto tangent_to_prev_v = -ParametricSpikesSurface(nv - epsilon, nr, radius, a) + ParametricSpikesSurface(nv, nr, radius, a);
+			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
+
+			auto tangent_to_next_r = ParametricSpikesSurface(nv, nr + epsilon, radius, a) - ParametricSpikesSurface(nv, nr, radius, a);
+			auto tangent_to_prev_r = -ParametricSpikesSurface(nv, nr - epsilon, radius, a) + ParametricSpikesSurface(nv, nr, radius, a);
+			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
+
+			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
+			normals.push_back(surface_normal);
+		}
+	}
+	std::vector<GLuint> indices;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment - 1; ++v) {
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
+
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+		}
+	}
+	return Mesh{ std::move(positions), std::move(normals), std::move(indices) };
+}
+Mesh NewShapeMesh(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment) {
+	std::vector<glm::vec3> positions;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			positions.push_back(ParametricNewShapeSurface(v / double(vertical_segment - 1), r / double(rotation_segment), radius, a) + center);
+		}
+	}
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			auto nv = v / double(vertical_segment - 1);
+			auto nr = r / double(rotation_segment);
+			auto epsilon = glm::epsilon<double>();
+
+			auto tangent_to_next_v = ParametricNewShapeSurface(nv + epsilon, nr, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_to_prev_v = -ParametricNewShapeSurface(nv - epsilon, nr, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
+
+			auto tangent_to_next_r = ParametricNewShapeSurface(nv, nr + epsilon, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_to_prev_r = -ParametricNewShapeSurface(nv, nr - epsilon, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
+
+			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
+			normals.push_back(-surface_normal);//dunno why but normals were wrong, this fixes it.
+		}
+	}
+	std::vector<GLuint> indices;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment - 1; ++v) {
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
+
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+		}
+	}
+	return Mesh{ std::move(positions), std::move(normals), std::move(indices) };
+}
+//same surface as NewShapeMesh, but the rings sit at adaptive t values instead of vertical_segment uniform ones.
+//every ring uses the same t values, so the grid has no t-junctions between columns.
+Mesh AdaptiveNewShapeMesh(const glm::dvec3& center, const double& radius, int a, double tolerance, const int& rotation_segment) {
+	auto samples = AdaptiveProfileSamples([radius, a](double t) { return ParametricNewCurve(t, radius, a); }, tolerance);
+	int vertical_segment = int(samples.size());
+
+	std::vector<glm::vec3> positions;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			positions.push_back(ParametricNewShapeSurface(samples[v], r / double(rotation_segment), radius, a) + center);
+		}
+	}
+	std::vector<glm::vec3> normals;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment; ++v) {
+			auto nv = samples[v];
+			auto nr = r / double(rotation_segment);
+			auto epsilon = glm::epsilon<double>();
+
+			auto tangent_to_next_v = ParametricNewShapeSurface(nv + epsilon, nr, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_to_prev_v = -ParametricNewShapeSurface(nv - epsilon, nr, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_v = (tangent_to_next_v + tangent_to_prev_v) / 2.;
+
+			auto tangent_to_next_r = ParametricNewShapeSurface(nv, nr + epsilon, radius, a) - ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_to_prev_r = -ParametricNewShapeSurface(nv, nr - epsilon, radius, a) + ParametricNewShapeSurface(nv, nr, radius, a);
+			auto tangent_r = (tangent_to_next_r + tangent_to_prev_r) / 2.;
+
+			auto surface_normal = glm::normalize(glm::cross(tangent_r, tangent_v));
+			normals.push_back(-surface_normal);//same flip as NewShapeMesh
+		}
+	}
+	std::vector<GLuint> indices;
+	for (int r = 0; r < rotation_segment; ++r) {
+		for (int v = 0; v < vertical_segment - 1; ++v) {
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r, vertical_segment, rotation_segment));
+
+			indices.push_back(VRtoIndex(v + 1, r, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v + 1, r + 1, vertical_segment, rotation_segment));
+			indices.push_back(VRtoIndex(v, r + 1, vertical_segment, rotation_segment));
+		}
+	}
+	return Mesh{ std::move(positions), std::move(normals), std::move(indices) };
+}
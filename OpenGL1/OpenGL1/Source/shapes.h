@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+//the shapes only build CPU side arrays, nothing here calls OpenGL.
+//main.cpp uploads them with VAO(mesh) through the mesh cache of mars_rover_openGL, the benchmark in mars_rover_openGL/MeshBenchmark runs them without a context.
+
+/* Parametric functions */
+glm::dvec2 ParametricHalfCircle(double t, double radius);
+glm::dvec2 ParametricCircle(double t, glm::dvec2 center, double radius);
+glm::dvec2 ParametricSpikes(double t, double radius, int a);
+glm::dvec2 ParametricNewCurve(double t, double radius, int a);
+int VRtoIndex(int v, int r, int vertical_segment, int rotation_segment);
+glm::dvec3 ParametricSphere(double t, double r, double radius);
+glm::dvec3 ParametricTorus(double t, double r, glm::dvec2 center_of_circle, double radius);
+glm::dvec3 ParametricSpikesSurface(double t, double r, double radius, int a);
+glm::dvec3 ParametricNewShapeSurface(double t, double r, double radius, int a);
+
+/* Meshes */
+//part of the mesh cache keys in main.cpp, bump it when a shape's mesh changes so the stored ones aren't loaded anymore
+constexpr uint32_t shapes_revision = 1;
+
+struct Mesh {
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<GLuint> indices;
+};
+
+Mesh SphereMesh(const glm::dvec3& center, const double& radius, const int& vertical_segment, const int& rotation_segment);
+Mesh TorusMesh(const glm::dvec3& center, const double& radius, glm::dvec2 center_of_circle, const int& vertical_segment, const int& rotation_segment);
+Mesh SpikesMesh(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment);
+Mesh NewShapeMesh(const glm::dvec3& center, const double& radius, int a, const int& vertical_segment, const int& rotation_segment);
+//rings at AdaptiveProfileSamples t values instead of uniform ones, positions.size() / rotation_segment of them
+Mesh AdaptiveNewShapeMesh(const glm::dvec3& center, const double& radius, int a, double tolerance, const int& rotation_segment);
@@ -0,0 +1,1109 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GLAD/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "extras.h"
+#include "gpu_generators.h"
+#include "heightmap.h"
+#include "mesh_utilities.h"
+#include "shapes.h"
+#include "spheres.h"
+#include "terrain.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+/*
+	Headless benchmark of the mesh generators, GenerateParametricShapeFrom2D and GenerateParametricShapeFrom3D of
+	this solution and the shapes of OpenGL1 behind its VAO generators. The function_pointer and lambda cases
+	compare the templated generator calling its profile through a pointer with one it can inline. The adaptive
+	cases run GenerateAdaptiveShapeFrom2D at the chord error of the uniform grid with the same vertical segment
+	count and report their vertices against the grid's as vertex_ratio. Profiles of constant curvature, like the
+	half circle, gain nothing from it. Nothing is uploaded, so they run without a
+	window or a GL context. Every case is run once for its allocations, then repeated for at least --min-time
+	seconds and the fastest run is reported. The results go to stdout or --output as JSON, progress to stderr.
+	The from_2d and from_3d cases run again at --scaling-segments, at most --max-segments, on 1, 2, 4 and so on up
+	to --max-threads threads, every core by default, for their speedup over one thread. Every mesh has to match
+	the single threaded one byte for byte, or the run fails.
+	The sphere tessellations are compared on triangles against their largest distance from the unit sphere, up to
+	--sphere-max-triangles, and on how many triangles each one needs for a few errors.
+	Terrain chunks are built from --heightmap, a flat sphere if it can't be read, for the time and memory a chunk
+	takes on one thread and how many chunks every core builds in a second.
+	ParametricSpikes at --simplify-segments, at most --max-segments, x twice that, welded, is simplified to a quarter, a sixteenth and so on
+	of its triangles and to a few errors, each once from the full mesh. Every result has to stay manifold, without
+	degenerate triangles or triangles across the u seam, or the run fails.
+	The batch profiles are checked against their scalar versions over all of t in [0, 1], a difference over
+	batch_profile_max_error fails the run.
+	The GPU generators are checked against the CPU generators for every profile with a GLSL version, in the
+	context of a hidden window, e.g. Mesa's llvmpipe under a virtual X server. Any mismatch fails the run, without
+	a context or compute shaders the section is skipped.
+	--filter runs the cases and sections whose name starts with it, like from_2d/spikes, opengl1 or simplify.
+
+	MeshBenchmark [--min-segments 16] [--max-segments 8192] [--threads 1] [--min-time 0.2] [--filter name]
+		[--sphere-max-triangles 2000000] [--heightmap ../Textures2_Camera_Projections/Assets/mars_1k_color.jpg]
+		[--simplify-segments 256] [--scaling-segments 1024] [--max-threads cores] [--output file]
+*/
+
+/* Allocation Tracking */
+// Every allocation carries its size in front of it, so the live heap can be tracked through delete too
+namespace
+{
+	constexpr size_t allocation_header = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+	std::atomic<size_t> allocated_bytes(0);
+	std::atomic<size_t> allocation_count(0);
+	std::atomic<size_t> live_bytes(0);
+	std::atomic<size_t> peak_live_bytes(0);
+}
+
+void* operator new(size_t size)
+{
+	auto block = static_cast<char*>(std::malloc(size + allocation_header));
+	if (!block)
+		throw std::bad_alloc();
+	*reinterpret_cast<size_t*>(block) = size;
+
+	allocated_bytes += size;
+	++allocation_count;
+	auto live = live_bytes += size;
+	auto peak = peak_live_bytes.load();
+	while (live > peak && !peak_live_bytes.compare_exchange_weak(peak, live));
+	return block + allocation_header;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	if (!pointer)
+		return;
+	// Through an integer, GCC takes the header in front of an inlined delete for an out of bounds read otherwise
+	auto block = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(pointer) - allocation_header);
+	live_bytes -= *reinterpret_cast<size_t*>(block);
+	std::free(block);
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete(pointer); }
+
+// High-water mark of the whole process, it never goes back down between cases
+static size_t PeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return size_t(usage.ru_maxrss);
+#else
+	return size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/* Benchmark Cases */
+struct MeshSize
+{
+	size_t vertices = 0;
+	size_t indices = 0;
+	size_t uniform_vertices = 0;	// Adaptive cases only, vertices of the uniform grid with the same error
+};
+
+// What the from_2d and from_3d cases generate, kept for the thread scaling comparison
+struct GeneratedMesh
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;	// Empty for from_3d
+	std::vector<GLuint> indices;
+	size_t uniform_vertices = 0;	// See MeshSize
+};
+
+struct BenchmarkCase
+{
+	std::string name;
+	// Generates a mesh of the given segment counts, keeps it alive until it returns
+	std::function<MeshSize(int vertical_segments, int rotation_segments, int thread_count)> generate;
+	// The same generator writing into mesh, for the cases whose generators take a thread count. Empty otherwise.
+	std::function<void(GeneratedMesh& mesh, int vertical_segments, int rotation_segments, int thread_count)> generate_mesh = nullptr;
+};
+
+// A case around a generator that fills a GeneratedMesh
+static BenchmarkCase GeneratorCase(const std::string& name, const std::function<void(GeneratedMesh&, int, int, int)>& generate_mesh)
+{
+	auto generate = [generate_mesh](int vs, int rs, int threads)
+	{
+		GeneratedMesh mesh;
+		generate_mesh(mesh, vs, rs, threads);
+		return MeshSize{ mesh.positions.size(), mesh.indices.size(), mesh.uniform_vertices };
+	};
+	return BenchmarkCase{ name, generate, generate_mesh };
+}
+
+struct BenchmarkResult
+{
+	std::string name;
+	int vertical_segments;
+	int rotation_segments;
+	MeshSize mesh;
+	int iterations = 0;
+	double seconds = 0;			// Fastest run
+	size_t allocated_bytes = 0;	// Of the first run
+	size_t allocations = 0;
+	size_t peak_heap_bytes = 0;	// Live heap above what was allocated before the first run
+	size_t peak_rss_bytes = 0;
+};
+
+static glm::dvec3 ParametricSphereSurface(double t, double r)
+{
+	return glm::rotateY(glm::dvec3(ParametricHalfCircle(t), 0), r * glm::two_pi<double>());
+}
+
+// Largest distance between the profile and the polyline through the vertical_segments uniform samples of the grid
+// generators, sampled inside each of its vertical_segments - 1 chords. Allocates nothing, so it doesn't show up in
+// the allocations of a case.
+static double UniformChordError(glm::dvec2(*parametric_line)(double), int vertical_segments)
+{
+	constexpr int inner_samples = 8;
+	auto chords = vertical_segments - 1;
+	double error = 0;
+	auto a = parametric_line(0);
+	for (int v = 1; v <= chords; ++v)
+	{
+		auto b = parametric_line(v / double(chords));
+		for (int i = 1; i < inner_samples; ++i)
+		{
+			auto t = (v - 1 + i / double(inner_samples)) / chords;
+			error = std::max(error, DistanceToSegment(parametric_line(t), a, b));
+		}
+		a = b;
+	}
+	return error;
+}
+
+// The templated generator with the profile as a function pointer it calls through, the old function pointer path,
+// against a lambda it can inline into its loops. Both evaluate the scalar profile, finite difference normals.
+template <glm::dvec2(*Line)(double)>
+static void AddCallableCases(std::vector<BenchmarkCase>& cases, const char* profile_name)
+{
+	auto name = std::string("from_2d/") + profile_name + "/finite_difference";
+	auto line = Line;
+	cases.push_back(GeneratorCase(name + "/function_pointer", [line](GeneratedMesh& mesh, int vs, int rs, int threads)
+	{
+		GeneratorOptions options;
+		options.thread_count = threads;
+		GenerateParametricShapeFrom2D<glm::dvec2(*)(double)>(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, line, vs, rs, options);
+	}));
+	cases.push_back(GeneratorCase(name + "/lambda", [](GeneratedMesh& mesh, int vs, int rs, int threads)
+	{
+		GeneratorOptions options;
+		options.thread_count = threads;
+		GenerateParametricShapeFrom2D(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, [](double t) { return Line(t); }, vs, rs, options);
+	}));
+}
+
+static std::vector<BenchmarkCase> BenchmarkCases()
+{
+	std::vector<BenchmarkCase> cases;
+
+	struct Profile
+	{
+		const char* name;
+		glm::dvec2(*line)(double);
+		glm::dvec2(*derivative)(double);
+	};
+	const Profile profiles[] = {
+		{ "half_circle", ParametricHalfCircle, ParametricHalfCircleDerivative },
+		{ "circle", ParametricCircle, ParametricCircleDerivative },
+		{ "spikes", ParametricSpikes, ParametricSpikesDerivative }
+	};
+
+	for (const auto& profile : profiles)
+	{
+		auto line = profile.line;
+		auto derivative = profile.derivative;
+		cases.push_back(GeneratorCase(std::string("from_2d/") + profile.name + "/finite_difference", [line](GeneratedMesh& mesh, int vs, int rs, int threads)
+		{
+			GeneratorOptions options;
+			options.thread_count = threads;
+			GenerateParametricShapeFrom2D(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, line, vs, rs, options);
+		}));
+		cases.push_back(GeneratorCase(std::string("from_2d/") + profile.name + "/grid", [line](GeneratedMesh& mesh, int vs, int rs, int threads)
+		{
+			GeneratorOptions options;
+			options.normal_mode = NormalMode::Grid;
+			options.thread_count = threads;
+			GenerateParametricShapeFrom2D(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, line, vs, rs, options);
+		}));
+		cases.push_back(GeneratorCase(std::string("from_2d/") + profile.name + "/derivative", [line, derivative](GeneratedMesh& mesh, int vs, int rs, int threads)
+		{
+			GeneratorOptions options;
+			options.thread_count = threads;
+			GenerateParametricShapeFrom2D(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, line, derivative, vs, rs, options);
+		}));
+		// As close to the profile as the uniform grid of vs samples, with as few rings as that takes
+		cases.push_back(GeneratorCase(std::string("from_2d/") + profile.name + "/adaptive", [line](GeneratedMesh& mesh, int vs, int rs, int threads)
+		{
+			GeneratorOptions options;
+			options.thread_count = threads;
+			GenerateAdaptiveShapeFrom2D(mesh.positions, mesh.normals, mesh.uvs, mesh.indices, line, UniformChordError(line, vs), rs, options);
+			mesh.uniform_vertices = size_t(vs) * rs;
+		}));
+	}
+
+	AddCallableCases<ParametricHalfCircle>(cases, "half_circle");
+	AddCallableCases<ParametricCircle>(cases, "circle");
+	AddCallableCases<ParametricSpikes>(cases, "spikes");
+
+	for (auto normal_mode : { NormalMode::FiniteDifference, NormalMode::Grid })
+	{
+		auto name = normal_mode == NormalMode::Grid ? "from_3d/sphere/grid" : "from_3d/sphere/finite_difference";
+		cases.push_back(GeneratorCase(name, [normal_mode](GeneratedMesh& mesh, int vs, int rs, int threads)
+		{
+			GeneratorOptions options;
+			options.normal_mode = normal_mode;
+			options.thread_count = threads;
+			GenerateParametricShapeFrom3D(mesh.positions, mesh.normals, mesh.indices, ParametricSphereSurface, vs, rs, options);
+		}));
+	}
+
+	// OpenGL1's VAO generators without the upload, same parameters as its main, single threaded
+	cases.push_back({ "opengl1/sphere", [](int vs, int rs, int)
+	{
+		auto mesh = SphereMesh(glm::dvec3(0), 0.3, vs, rs);
+		return MeshSize{ mesh.positions.size(), mesh.indices.size() };
+	} });
+	cases.push_back({ "opengl1/torus", [](int vs, int rs, int)
+	{
+		auto mesh = TorusMesh(glm::dvec3(0), 0.09, glm::dvec2(0.210, 0), vs, rs);
+		return MeshSize{ mesh.positions.size(), mesh.indices.size() };
+	} });
+	cases.push_back({ "opengl1/spikes", [](int vs, int rs, int)
+	{
+		auto mesh = SpikesMesh(glm::dvec3(0), 0.3, 12, vs, rs);
+		return MeshSize{ mesh.positions.size(), mesh.indices.size() };
+	} });
+	cases.push_back({ "opengl1/new_shape", [](int vs, int rs, int)
+	{
+		auto mesh = NewShapeMesh(glm::dvec3(0), 1, -10, vs, rs);
+		return MeshSize{ mesh.positions.size(), mesh.indices.size() };
+	} });
+
+	return cases;
+}
+
+static BenchmarkResult RunCase(const BenchmarkCase& benchmark_case, int vertical_segments, int rotation_segments, int thread_count, double min_time)
+{
+	using Clock = std::chrono::steady_clock;
+
+	BenchmarkResult result;
+	result.name = benchmark_case.name;
+	result.vertical_segments = vertical_segments;
+	result.rotation_segments = rotation_segments;
+
+	auto bytes_before = allocated_bytes.load();
+	auto allocations_before = allocation_count.load();
+	auto live_before = live_bytes.load();
+	peak_live_bytes = live_before;
+
+	double total = 0;
+	while (result.iterations < 3 || total < min_time)
+	{
+		auto start = Clock::now();
+		result.mesh = benchmark_case.generate(vertical_segments, rotation_segments, thread_count);
+		auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		if (result.iterations == 0)
+		{
+			result.seconds = seconds;
+			result.allocated_bytes = allocated_bytes - bytes_before;
+			result.allocations = allocation_count - allocations_before;
+			result.peak_heap_bytes = peak_live_bytes - live_before;
+		}
+		result.seconds = std::min(result.seconds, seconds);
+		total += seconds;
+		++result.iterations;
+	}
+	result.peak_rss_bytes = PeakResidentBytes();
+	return result;
+}
+
+/* Selection */
+// --filter is a prefix of the case or section name, an empty one selects everything
+static bool Selected(const std::string& name, const std::string& filter)
+{
+	return name.compare(0, filter.size(), filter) == 0;
+}
+
+/* Thread Scaling */
+struct ThreadScalingResult
+{
+	std::string name;
+	int vertical_segments;
+	int rotation_segments;
+	int thread_count;
+	double seconds;		// Fastest run
+	double speedup;		// Of the single threaded run over this one
+	bool matches;		// Positions, normals, uvs and indices byte for byte the same as with one thread
+};
+
+// 1, 2, 4 and so on below max_threads, then max_threads itself
+static std::vector<int> ThreadCounts(int max_threads)
+{
+	std::vector<int> counts;
+	for (int threads = 1; threads < max_threads; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(std::max(max_threads, 1));
+	return counts;
+}
+
+template <typename T>
+static bool SameBytes(const std::vector<T>& a, const std::vector<T>& b)
+{
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+// Every case with a threaded generator at every thread count, timed and checked against its single threaded mesh
+static std::vector<ThreadScalingResult> BenchmarkThreadScaling(
+	const std::vector<BenchmarkCase>& cases,
+	const std::string& filter,
+	int vertical_segments,
+	int max_threads,
+	double min_time
+)
+{
+	std::vector<ThreadScalingResult> results;
+	auto rotation_segments = std::max(vertical_segments / 2, 2);
+	for (const auto& benchmark_case : cases)
+	{
+		if (!benchmark_case.generate_mesh || !Selected("thread_scaling/" + benchmark_case.name, filter))
+			continue;
+
+		GeneratedMesh serial;
+		benchmark_case.generate_mesh(serial, vertical_segments, rotation_segments, 1);
+
+		double serial_seconds = 0;
+		for (auto thread_count : ThreadCounts(max_threads))
+		{
+			auto timed = RunCase(benchmark_case, vertical_segments, rotation_segments, thread_count, min_time);
+			if (thread_count == 1)
+				serial_seconds = timed.seconds;
+
+			GeneratedMesh parallel;
+			benchmark_case.generate_mesh(parallel, vertical_segments, rotation_segments, thread_count);
+			auto matches = SameBytes(parallel.positions, serial.positions) && SameBytes(parallel.normals, serial.normals)
+				&& SameBytes(parallel.uvs, serial.uvs) && SameBytes(parallel.indices, serial.indices);
+
+			ThreadScalingResult result{ benchmark_case.name, vertical_segments, rotation_segments, thread_count, timed.seconds,
+				timed.seconds > 0 ? serial_seconds / timed.seconds : 0., matches };
+			std::cerr << "thread_scaling/" << result.name << " " << vertical_segments << "x" << rotation_segments << " on "
+				<< thread_count << " threads: " << result.speedup << "x, " << (matches ? "matches" : "differs") << std::endl;
+			results.push_back(result);
+		}
+	}
+	return results;
+}
+
+/* Sphere Tessellations */
+struct SphereErrorResult
+{
+	std::string tessellation;
+	int segments;				// Vertical segments of the uv sphere, edge segments of the others
+	MeshSize mesh;
+	size_t triangles = 0;		// Without the collapsed pole rows of the uv sphere
+	double max_error = 0;
+	double seconds = 0;			// One run
+};
+
+static const char* const sphere_tessellations[] = { "uv_sphere", "icosphere", "cube_sphere" };
+static const double sphere_target_errors[] = { 1e-2, 1e-3, 1e-4, 1e-5 };
+
+static std::vector<SphereErrorResult> CompareSphereTessellations(size_t max_triangles)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<SphereErrorResult> results;
+	for (const auto tessellation : sphere_tessellations)
+	{
+		// The uv sphere like the LOD chain it replaced, half as many rotation segments as vertical ones.
+		// The cube sphere rounds odd edge segments up.
+		auto uv_sphere = !strcmp(tessellation, "uv_sphere");
+		auto cube_sphere = !strcmp(tessellation, "cube_sphere");
+		for (auto segments = uv_sphere ? 8 : cube_sphere ? 2 : 1; ; segments *= 2)
+		{
+			std::vector<glm::vec3> positions, normals;
+			std::vector<glm::vec2> uvs;
+			std::vector<GLuint> indices;
+
+			auto start = Clock::now();
+			if (uv_sphere)
+				GenerateParametricShapeFrom2D(positions, normals, uvs, indices, ParametricHalfCircle, ParametricHalfCircleDerivative, segments, segments / 2);
+			else
+				GenerateSphere(positions, normals, uvs, indices,
+					cube_sphere ? SphereTessellation::CubeSphere : SphereTessellation::Icosphere, segments);
+
+			SphereErrorResult result;
+			result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			result.tessellation = tessellation;
+			result.segments = segments;
+			result.mesh = MeshSize{ positions.size(), indices.size() };
+			result.triangles = CountNonDegenerateTriangles(positions, indices);
+			result.max_error = MaxSphereDeviation(positions, indices);
+			if (result.triangles > max_triangles)
+				break;
+
+			std::cerr << tessellation << " " << segments << ": " << result.triangles << " triangles, max error "
+				<< result.max_error << std::endl;
+			results.push_back(result);
+		}
+	}
+	return results;
+}
+
+// Triangles a tessellation needs for target_error, 0 if no size got there. The sizes double, so between the two
+// around the target it's interpolated on a line in log-log, the error falls with a power of the triangle count.
+static double TrianglesForError(const std::vector<SphereErrorResult>& results, const std::string& tessellation, double target_error)
+{
+	const SphereErrorResult* previous = nullptr;
+	for (const auto& result : results)
+	{
+		if (result.tessellation != tessellation)
+			continue;
+		if (result.max_error <= target_error)
+		{
+			if (!previous || previous->max_error <= result.max_error)
+				return double(result.triangles);
+			auto t = std::log(previous->max_error / target_error) / std::log(previous->max_error / result.max_error);
+			return previous->triangles * std::pow(double(result.triangles) / previous->triangles, t);
+		}
+		previous = &result;
+	}
+	return 0;
+}
+
+/* Terrain Chunks */
+struct TerrainChunkResult
+{
+	int segments;
+	int chunks;					// Every depth 3 chunk of the six faces
+	int parallel_threads;
+	double seconds_per_chunk = 0;	// Single threaded, what a worker spends on a chunk
+	double chunks_per_second = 0;	// With a thread per core
+	size_t mesh_bytes = 0;		// Per chunk, the arrays handed over to the upload
+	size_t allocated_bytes = 0;	// Per chunk, along with the scratch of the build
+};
+
+static std::vector<TerrainChunkResult> BenchmarkTerrainChunks(const Heightmap* heightmap)
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int depth = 3;
+	std::vector<TerrainChunkResult> results;
+	for (int segments = 16; segments <= 128; segments *= 2)
+	{
+		TerrainOptions options;
+		options.chunk_segments = segments;
+		std::vector<TerrainChunkKey> keys;
+		for (int face = 0; face < 6; ++face)
+			for (uint32_t y = 0; y < 1u << depth; ++y)
+				for (uint32_t x = 0; x < 1u << depth; ++x)
+					keys.push_back(TerrainChunkKey{ face, depth, x, y });
+
+		TerrainChunkResult result;
+		result.segments = segments;
+		result.chunks = int(keys.size());
+		result.parallel_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+
+		auto bytes_before = allocated_bytes.load();
+		auto start = Clock::now();
+		for (const auto& key : keys)
+			result.mesh_bytes += BuildTerrainChunkMesh(key, options, heightmap).ByteSize();
+		result.seconds_per_chunk = std::chrono::duration<double>(Clock::now() - start).count() / keys.size();
+		result.allocated_bytes = (allocated_bytes - bytes_before) / keys.size();
+		result.mesh_bytes /= keys.size();
+
+		start = Clock::now();
+		ParallelFor(int(keys.size()), result.parallel_threads, [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+				BuildTerrainChunkMesh(keys[i], options, heightmap);
+		});
+		result.chunks_per_second = keys.size() / std::chrono::duration<double>(Clock::now() - start).count();
+
+		std::cerr << "terrain_chunks " << segments << ": " << result.seconds_per_chunk * 1000 << " ms and "
+			<< result.mesh_bytes / 1024. << " KiB per chunk, " << result.chunks_per_second << " chunks/s on "
+			<< result.parallel_threads << " threads" << std::endl;
+		results.push_back(result);
+	}
+	return results;
+}
+
+/* Simplification */
+struct SimplifyResult
+{
+	size_t target_triangles;	// 0 when only target_error limits it
+	double target_error;
+	SimplifyStats stats;
+	double seconds;
+
+	// Of the simplified mesh, all 0 for a valid one
+	size_t degenerate_triangles;	// Two corners at the same position
+	size_t duplicate_edges;			// Directed edges between two positions used by more than one triangle
+	size_t seam_triangles;			// Triangles whose uvs span more than half of u, across the seam
+
+	bool Valid() const { return degenerate_triangles == 0 && duplicate_edges == 0 && seam_triangles == 0; }
+};
+
+static const double simplify_target_errors[] = { 1e-3, 1e-4 };
+
+// Checks on positions, not vertices: the seam vertices are welded positions with two uvs each
+static void CheckSimplifiedMesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs, const std::vector<GLuint>& indices, SimplifyResult& result)
+{
+	std::vector<GLuint> order(positions.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = GLuint(i);
+	auto less = [&](GLuint a, GLuint b)
+	{
+		const auto& p = positions[a];
+		const auto& q = positions[b];
+		return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+	};
+	std::sort(order.begin(), order.end(), less);
+	std::vector<GLuint> position_ids(positions.size());
+	GLuint id = 0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		if (i > 0 && less(order[i - 1], order[i]))
+			++id;
+		position_ids[order[i]] = id;
+	}
+
+	result.degenerate_triangles = result.duplicate_edges = result.seam_triangles = 0;
+	std::vector<uint64_t> edges;
+	edges.reserve(indices.size());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		GLuint corners[3] = { position_ids[indices[i]], position_ids[indices[i + 1]], position_ids[indices[i + 2]] };
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+			++result.degenerate_triangles;
+		for (int c = 0; c < 3; ++c)
+			edges.push_back(uint64_t(corners[c]) << 32 | corners[(c + 1) % 3]);
+
+		auto u_min = std::min({ uvs[indices[i]].x, uvs[indices[i + 1]].x, uvs[indices[i + 2]].x });
+		auto u_max = std::max({ uvs[indices[i]].x, uvs[indices[i + 1]].x, uvs[indices[i + 2]].x });
+		if (u_max - u_min > 0.5f)
+			++result.seam_triangles;
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 1; i < edges.size(); ++i)
+		if (edges[i] == edges[i - 1])
+			++result.duplicate_edges;
+}
+
+static std::vector<SimplifyResult> BenchmarkSimplification(int vertical_segments)
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+	GenerateParametricShapeFrom2D(positions, normals, uvs, indices, ParametricSpikes, ParametricSpikesDerivative, vertical_segments, vertical_segments * 2);
+	WeldVertices(positions, normals, uvs, indices);
+
+	std::vector<SimplifyOptions> runs;
+	for (auto target_triangles = indices.size() / 3 / 4; target_triangles >= 1000; target_triangles /= 4)
+	{
+		SimplifyOptions options;
+		options.target_triangles = target_triangles;
+		options.target_error = std::numeric_limits<float>::max();
+		runs.push_back(options);
+	}
+	for (auto target_error : simplify_target_errors)
+	{
+		SimplifyOptions options;
+		options.target_error = float(target_error);
+		runs.push_back(options);
+	}
+
+	// Too slow to repeat, every run is timed once
+	std::vector<SimplifyResult> results;
+	for (const auto& options : runs)
+	{
+		auto run_positions = positions;
+		auto run_normals = normals;
+		auto run_uvs = uvs;
+		auto run_indices = indices;
+
+		auto start = Clock::now();
+		auto stats = SimplifyMesh(run_positions, run_normals, run_uvs, run_indices, options);
+		auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+		auto error_limited = options.target_triangles == 0;
+		SimplifyResult result{ options.target_triangles, error_limited ? options.target_error : 0., stats, seconds, 0, 0, 0 };
+		CheckSimplifiedMesh(run_positions, run_uvs, run_indices, result);
+		std::cerr << "simplify " << vertical_segments << "x" << vertical_segments * 2 << ": "
+			<< stats.triangles_before << " -> " << stats.triangles_after << " triangles, error " << stats.error
+			<< ", " << stats.passes << " passes, " << seconds * 1000 << " ms" << std::endl;
+		if (!result.Valid())
+			std::cerr << "simplify failed: " << result.degenerate_triangles << " degenerate triangles, "
+				<< result.duplicate_edges << " non manifold edges, " << result.seam_triangles << " triangles across the seam" << std::endl;
+		results.push_back(result);
+	}
+	return results;
+}
+
+/* Batch Profiles */
+struct BatchProfileResult
+{
+	std::string name;
+	size_t samples;
+	double max_error;	// Largest difference of a coordinate from the scalar profile
+};
+
+// The SIMD sin and cos are within a couple of ulps of the C library, the profiles are unit sized, so about 4 ulps
+static const double batch_profile_max_error = 1e-15;
+
+static std::vector<BatchProfileResult> CheckBatchProfiles()
+{
+	struct Profile
+	{
+		const char* name;
+		glm::dvec2(*line)(double);
+		void(*batch)(const double*, glm::dvec2*, int);
+	};
+	const Profile profiles[] = {
+		{ "half_circle", ParametricHalfCircle, ParametricHalfCircleBatch },
+		{ "circle", ParametricCircle, ParametricCircleBatch },
+		{ "spikes", ParametricSpikes, ParametricSpikesBatch }
+	};
+
+	// Evenly spaced with both ends, the odd count leaves a tail for the scalar loop after the SIMD ones
+	const int samples = (1 << 22) + 3;
+	std::vector<double> t(samples);
+	for (int i = 0; i < samples; ++i)
+		t[i] = i / double(samples - 1);
+	std::vector<glm::dvec2> batch(samples);
+
+	std::vector<BatchProfileResult> results;
+	for (const auto& profile : profiles)
+	{
+		profile.batch(t.data(), batch.data(), samples);
+
+		BatchProfileResult result{ std::string("batch_profiles/") + profile.name, size_t(samples), 0 };
+		for (int i = 0; i < samples; ++i)
+		{
+			auto difference = glm::abs(batch[i] - profile.line(t[i]));
+			result.max_error = std::max(result.max_error, std::max(difference.x, difference.y));
+		}
+
+		std::cerr << result.name << ": max error " << result.max_error << " over " << samples << " samples"
+			<< (result.max_error > batch_profile_max_error ? ", over the bound" : "") << std::endl;
+		results.push_back(result);
+	}
+	return results;
+}
+
+/* GPU Generation */
+struct GPUGenerationResult
+{
+	std::string name;
+	int vertical_segments;
+	int rotation_segments;
+	GenerationComparison comparison;
+};
+
+static std::vector<GPUGenerationResult> CompareGPUGeneration()
+{
+	std::vector<GPUGenerationResult> results;
+	if (!glfwInit())
+	{
+		std::cerr << "gpu_generators skipped: GLFW couldn't be initialized" << std::endl;
+		return results;
+	}
+
+	// The same context as the scene's, never shown
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+	auto window = glfwCreateWindow(64, 64, "MeshBenchmark", NULL, NULL);
+	if (!window)
+	{
+		std::cerr << "gpu_generators skipped: no GL 3.3 context" << std::endl;
+		glfwTerminate();
+		return results;
+	}
+	glfwMakeContextCurrent(window);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) || !GPUGenerationSupported())
+		std::cerr << "gpu_generators skipped: no compute shaders" << std::endl;
+	else
+	{
+		struct Profile
+		{
+			const char* name;
+			glm::dvec2(*line)(double);
+			glm::dvec2(*derivative)(double);
+		};
+		const Profile profiles[] = {
+			{ "half_circle", ParametricHalfCircle, ParametricHalfCircleDerivative },
+			{ "circle", ParametricCircle, ParametricCircleDerivative },
+			{ "spikes", ParametricSpikes, ParametricSpikesDerivative }
+		};
+		const int sizes[][2] = { { 32, 16 }, { 256, 128 } };
+
+		for (const auto& profile : profiles)
+			for (auto normal_mode : { NormalMode::FiniteDifference, NormalMode::Grid })
+				for (auto topology : { Topology::Triangles, Topology::TriangleStrips })
+					for (const auto& size : sizes)
+					{
+						GeneratorOptions options;
+						options.normal_mode = normal_mode;
+						options.topology = topology;
+
+						auto vao = GenerateParametricShapeFrom2DGPU(profile.line, profile.derivative, size[0], size[1], options);
+						GPUGenerationResult result{
+							std::string("gpu_generators/") + profile.name + (normal_mode == NormalMode::Grid ? "/grid" : "/derivative")
+								+ (topology == Topology::TriangleStrips ? "/strips" : ""),
+							size[0], size[1],
+							CompareWithCPUGeneration(vao, profile.line, profile.derivative, size[0], size[1], options)
+						};
+						vao.Release();
+
+						std::cerr << result.name << " " << size[0] << "x" << size[1] << ": "
+							<< (result.comparison.Matches() ? "matches" : "differs") << ", position error " << result.comparison.max_position_error
+							<< ", normal error " << result.comparison.max_normal_error << ", uv error " << result.comparison.max_uv_error
+							<< ", " << result.comparison.index_mismatches << " index mismatches" << std::endl;
+						results.push_back(result);
+					}
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return results;
+}
+
+/* JSON Output */
+static void WriteResults(
+	std::ostream& out,
+	const std::vector<BenchmarkResult>& results,
+	const std::vector<ThreadScalingResult>& scaling_results,
+	const std::vector<SphereErrorResult>& sphere_results,
+	const std::vector<TerrainChunkResult>& terrain_results,
+	const std::vector<SimplifyResult>& simplify_results,
+	const std::vector<BatchProfileResult>& batch_results,
+	const std::vector<GPUGenerationResult>& gpu_results,
+	int thread_count,
+	double min_time
+)
+{
+	out << "{\n";
+	out << "\t\"benchmark\": \"MeshBenchmark\",\n";
+	out << "\t\"thread_count\": " << thread_count << ",\n";
+	out << "\t\"min_time\": " << min_time << ",\n";
+	out << "\t\"results\": [";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const auto& result = results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"name\": \"" << result.name << "\""
+			<< ", \"vertical_segments\": " << result.vertical_segments
+			<< ", \"rotation_segments\": " << result.rotation_segments
+			<< ", \"vertices\": " << result.mesh.vertices
+			<< ", \"indices\": " << result.mesh.indices;
+		if (result.mesh.uniform_vertices)
+			out << ", \"uniform_vertices\": " << result.mesh.uniform_vertices
+				<< ", \"vertex_ratio\": " << result.mesh.vertices / double(result.mesh.uniform_vertices);
+		out << ", \"iterations\": " << result.iterations
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"vertices_per_second\": " << (result.seconds > 0 ? result.mesh.vertices / result.seconds : 0.)
+			<< ", \"allocated_bytes\": " << result.allocated_bytes
+			<< ", \"allocations\": " << result.allocations
+			<< ", \"peak_heap_bytes\": " << result.peak_heap_bytes
+			<< ", \"peak_rss_bytes\": " << result.peak_rss_bytes << " }";
+	}
+	out << "\n\t],\n";
+
+	// speedup over the single threaded run of the same case
+	out << "\t\"thread_scaling\": [";
+	for (size_t i = 0; i < scaling_results.size(); ++i)
+	{
+		const auto& result = scaling_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"name\": \"" << result.name << "\""
+			<< ", \"vertical_segments\": " << result.vertical_segments
+			<< ", \"rotation_segments\": " << result.rotation_segments
+			<< ", \"threads\": " << result.thread_count
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"speedup\": " << result.speedup
+			<< ", \"matches\": " << (result.matches ? "true" : "false") << " }";
+	}
+	out << "\n\t],\n";
+
+	out << "\t\"sphere_tessellations\": [";
+	for (size_t i = 0; i < sphere_results.size(); ++i)
+	{
+		const auto& result = sphere_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"tessellation\": \"" << result.tessellation << "\""
+			<< ", \"segments\": " << result.segments
+			<< ", \"vertices\": " << result.mesh.vertices
+			<< ", \"indices\": " << result.mesh.indices
+			<< ", \"triangles\": " << result.triangles
+			<< ", \"max_error\": " << result.max_error
+			<< ", \"seconds\": " << result.seconds << " }";
+	}
+	out << "\n\t],\n";
+
+	// null where no size reached the error
+	out << "\t\"triangles_for_error\": [";
+	for (size_t i = 0; i < sizeof(sphere_target_errors) / sizeof(sphere_target_errors[0]); ++i)
+	{
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"max_error\": " << sphere_target_errors[i];
+		for (const auto tessellation : sphere_tessellations)
+		{
+			auto triangles = TrianglesForError(sphere_results, tessellation, sphere_target_errors[i]);
+			out << ", \"" << tessellation << "\": ";
+			if (triangles)
+				out << size_t(triangles + 0.5);
+			else
+				out << "null";
+		}
+		out << " }";
+	}
+	out << "\n\t],\n";
+
+	out << "\t\"terrain_chunks\": [";
+	for (size_t i = 0; i < terrain_results.size(); ++i)
+	{
+		const auto& result = terrain_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"segments\": " << result.segments
+			<< ", \"chunks\": " << result.chunks
+			<< ", \"seconds_per_chunk\": " << result.seconds_per_chunk
+			<< ", \"mesh_bytes_per_chunk\": " << result.mesh_bytes
+			<< ", \"allocated_bytes_per_chunk\": " << result.allocated_bytes
+			<< ", \"parallel_threads\": " << result.parallel_threads
+			<< ", \"chunks_per_second\": " << result.chunks_per_second << " }";
+	}
+	out << "\n\t],\n";
+
+	// target_error is 0 for the runs limited by target_triangles only
+	out << "\t\"simplify\": [";
+	for (size_t i = 0; i < simplify_results.size(); ++i)
+	{
+		const auto& result = simplify_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"target_triangles\": " << result.target_triangles
+			<< ", \"target_error\": " << result.target_error
+			<< ", \"vertices_before\": " << result.stats.vertices_before
+			<< ", \"vertices\": " << result.stats.vertices_after
+			<< ", \"triangles_before\": " << result.stats.triangles_before
+			<< ", \"triangles\": " << result.stats.triangles_after
+			<< ", \"error\": " << result.stats.error
+			<< ", \"passes\": " << result.stats.passes
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"degenerate_triangles\": " << result.degenerate_triangles
+			<< ", \"duplicate_edges\": " << result.duplicate_edges
+			<< ", \"seam_triangles\": " << result.seam_triangles << " }";
+	}
+	out << "\n\t],\n";
+
+	out << "\t\"batch_profiles\": [";
+	for (size_t i = 0; i < batch_results.size(); ++i)
+	{
+		const auto& result = batch_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"name\": \"" << result.name << "\""
+			<< ", \"samples\": " << result.samples
+			<< ", \"max_error\": " << result.max_error
+			<< ", \"max_allowed_error\": " << batch_profile_max_error << " }";
+	}
+	out << "\n\t],\n";
+
+	out << "\t\"gpu_generators\": [";
+	for (size_t i = 0; i < gpu_results.size(); ++i)
+	{
+		const auto& result = gpu_results[i];
+		out << (i ? ",\n" : "\n");
+		out << "\t\t{ \"name\": \"" << result.name << "\""
+			<< ", \"vertical_segments\": " << result.vertical_segments
+			<< ", \"rotation_segments\": " << result.rotation_segments
+			<< ", \"max_position_error\": " << result.comparison.max_position_error
+			<< ", \"max_normal_error\": " << result.comparison.max_normal_error
+			<< ", \"max_uv_error\": " << result.comparison.max_uv_error
+			<< ", \"index_mismatches\": " << result.comparison.index_mismatches
+			<< ", \"matches\": " << (result.comparison.Matches() ? "true" : "false") << " }";
+	}
+	out << "\n\t]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+	int min_segments = 16;
+	int max_segments = 8192;
+	int thread_count = 1;
+	double min_time = 0.2;
+	size_t sphere_max_triangles = 2000000;
+	std::string heightmap_path = "../Textures2_Camera_Projections/Assets/mars_1k_color.jpg";
+	int simplify_segments = 256;
+	int scaling_segments = 1024;
+	int max_threads = std::max(int(std::thread::hardware_concurrency()), 1);
+	std::string filter;
+	std::string output_path;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		auto Argument = [&]() -> const char*
+		{
+			if (i + 1 >= argc)
+			{
+				std::cerr << argv[i] << " needs a value" << std::endl;
+				std::exit(1);
+			}
+			return argv[++i];
+		};
+
+		if (!strcmp(argv[i], "--min-segments"))
+			min_segments = std::max(2, atoi(Argument()));
+		else if (!strcmp(argv[i], "--max-segments"))
+			max_segments = atoi(Argument());
+		else if (!strcmp(argv[i], "--threads"))
+			thread_count = atoi(Argument());
+		else if (!strcmp(argv[i], "--min-time"))
+			min_time = atof(Argument());
+		else if (!strcmp(argv[i], "--filter"))
+			filter = Argument();
+		else if (!strcmp(argv[i], "--sphere-max-triangles"))
+			sphere_max_triangles = size_t(atof(Argument()));
+		else if (!strcmp(argv[i], "--heightmap"))
+			heightmap_path = Argument();
+		else if (!strcmp(argv[i], "--simplify-segments"))
+			simplify_segments = std::max(2, atoi(Argument()));
+		else if (!strcmp(argv[i], "--scaling-segments"))
+			scaling_segments = std::max(2, atoi(Argument()));
+		else if (!strcmp(argv[i], "--max-threads"))
+			max_threads = std::max(1, atoi(Argument()));
+		else if (!strcmp(argv[i], "--output"))
+			output_path = Argument();
+		else
+		{
+			std::cerr << "Unknown argument " << argv[i] << std::endl;
+			std::cerr << "MeshBenchmark [--min-segments 16] [--max-segments 8192] [--threads 1] [--min-time 0.2] [--filter name]"
+				" [--sphere-max-triangles 2000000] [--heightmap file] [--simplify-segments 256] [--scaling-segments 1024]"
+				" [--max-threads cores] [--output file]" << std::endl;
+			return 1;
+		}
+	}
+
+	auto cases = BenchmarkCases();
+	std::vector<BenchmarkResult> results;
+
+	// Every case at one size before the next size, so the process wide peak RSS only grows with the sizes.
+	// Rotation gets half the vertical segments, like the Mars LOD chain.
+	for (int segments = min_segments; segments <= max_segments; segments *= 2)
+	{
+		for (const auto& benchmark_case : cases)
+		{
+			if (!Selected(benchmark_case.name, filter))
+				continue;
+
+			auto result = RunCase(benchmark_case, segments, std::max(segments / 2, 2), thread_count, min_time);
+			std::cerr << result.name << " " << result.vertical_segments << "x" << result.rotation_segments << ": "
+				<< result.mesh.vertices / result.seconds / 1e6 << "M vertices/s, "
+				<< result.allocated_bytes / (1024. * 1024.) << " MiB allocated" << std::endl;
+			results.push_back(result);
+		}
+	}
+
+	// --filter thread_scaling runs every threaded case, thread_scaling/from_2d/spikes only those
+	auto scaling_results = BenchmarkThreadScaling(cases, filter, std::max(std::min(scaling_segments, max_segments), 2), max_threads, min_time);
+
+	// --filter sphere_tessellations runs only the comparison
+	std::vector<SphereErrorResult> sphere_results;
+	if (Selected("sphere_tessellations", filter))
+		sphere_results = CompareSphereTessellations(sphere_max_triangles);
+
+	std::vector<TerrainChunkResult> terrain_results;
+	if (Selected("terrain_chunks", filter))
+	{
+		// LoadHeightmap prints to stdout, which may be the JSON
+		Heightmap heightmap;
+		auto stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+		auto loaded = LoadHeightmap(heightmap, heightmap_path.c_str());
+		std::cout.rdbuf(stdout_buffer);
+		terrain_results = BenchmarkTerrainChunks(loaded ? &heightmap : nullptr);
+	}
+
+	std::vector<SimplifyResult> simplify_results;
+	if (Selected("simplify", filter))
+		simplify_results = BenchmarkSimplification(std::max(std::min(simplify_segments, max_segments), 2));
+
+	std::vector<BatchProfileResult> batch_results;
+	if (Selected("batch_profiles", filter))
+		batch_results = CheckBatchProfiles();
+
+	std::vector<GPUGenerationResult> gpu_results;
+	if (Selected("gpu_generators", filter))
+		gpu_results = CompareGPUGeneration();
+
+	if (output_path.empty())
+		WriteResults(std::cout, results, scaling_results, sphere_results, terrain_results, simplify_results, batch_results, gpu_results, thread_count, min_time);
+	else
+	{
+		std::ofstream file(output_path);
+		if (!file)
+		{
+			std::cerr << "Couldn't open " << output_path << std::endl;
+			return 1;
+		}
+		WriteResults(file, results, scaling_results, sphere_results, terrain_results, simplify_results, batch_results, gpu_results, thread_count, min_time);
+	}
+
+	// The results are written either way, to see what went wrong
+	for (const auto& result : scaling_results)
+		if (!result.matches)
+			return 1;
+	for (const auto& result : simplify_results)
+		if (!result.Valid())
+			return 1;
+	for (const auto& result : batch_results)
+		if (result.max_error > batch_profile_max_error)
+			return 1;
+	for (const auto& result : gpu_results)
+		if (!result.comparison.Matches())
+			return 1;
+	return 0;
+}
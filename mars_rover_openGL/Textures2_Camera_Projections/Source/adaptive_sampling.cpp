@@ -0,0 +1,43 @@
+#include "adaptive_sampling.h"
+
+/* Adaptive Sampling Helpers */
+double DistanceToSegment(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b)
+{
+	auto ab = b - a;
+	auto length_squared = glm::dot(ab, ab);
+	auto along = length_squared > 0 ? glm::clamp(glm::dot(p - a, ab) / length_squared, 0., 1.) : 0.;
+	return glm::length(p - (a + ab * along));
+}
+
+std::vector<int> SelectChordPoints(const std::vector<glm::dvec2>& points, double tolerance)
+{
+	auto last = int(points.size()) - 1;
+	auto Fits = [&points, tolerance](int begin, int end)
+	{
+		for (int i = begin + 1; i < end; ++i)
+			if (DistanceToSegment(points[i], points[begin], points[end]) > tolerance)
+				return false;
+		return true;
+	};
+
+	std::vector<int> kept{ 0 };
+	for (int begin = 0; begin < last;)
+	{
+		// Reach begin + fits is known to fit, begin + fails is known not to or lies past the end
+		int fits = 1;
+		while (begin + fits * 2 <= last && Fits(begin, begin + fits * 2))
+			fits *= 2;
+		int fails = glm::min(fits * 2, last - begin + 1);
+		while (fails - fits > 1)
+		{
+			auto reach = (fits + fails) / 2;
+			if (Fits(begin, begin + reach))
+				fits = reach;
+			else
+				fails = reach;
+		}
+		begin += fits;
+		kept.push_back(begin);
+	}
+	return kept;
+}
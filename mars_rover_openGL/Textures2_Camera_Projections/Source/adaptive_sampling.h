@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include "GLM/glm.hpp"
+
+/*
+	Curvature adaptive sampling of a 2D curve, shared with OpenGL1's AdaptiveNewShapeMesh. Only needs GLM, so it
+	builds into both solutions without the rest of the generators.
+*/
+
+/* Adaptive Sampling Helpers */
+double DistanceToSegment(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b);
+
+// Walks the points and extends every chord as far as all the points it skips stay within tolerance of it,
+// doubling the reach and then bisecting it. Returns the kept indices, first and last included.
+std::vector<int> SelectChordPoints(const std::vector<glm::dvec2>& points, double tolerance);
+
+// Sorted t values in [0, 1] whose polyline stays within tolerance of the profile, dense where it bends and
+// sparse where it is straight. The candidates are candidate_segments uniform segments, they have to resolve the
+// shortest wavelength of the profile.
+template <typename ParametricLine>
+std::vector<double> AdaptiveProfileSamples(const ParametricLine& parametric_line, double tolerance, int candidate_segments = 4096)
+{
+	std::vector<glm::dvec2> candidates(candidate_segments + 1);
+	for (int i = 0; i <= candidate_segments; ++i)
+		candidates[i] = parametric_line(i / double(candidate_segments));
+
+	auto kept = SelectChordPoints(candidates, tolerance);
+	std::vector<double> samples(kept.size());
+	for (size_t i = 0; i < kept.size(); ++i)
+		samples[i] = kept[i] / double(candidate_segments);
+	return samples;
+}
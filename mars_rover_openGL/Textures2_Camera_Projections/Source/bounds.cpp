@@ -0,0 +1,176 @@
+#include "bounds.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOUNDS_SSE2 1
+#else
+#define BOUNDS_SSE2 0
+#endif
+
+#if BOUNDS_SSE2
+// Four packed positions, x y z x | y z x y | z x y z, to one register per axis
+static inline void TransposePositions(const float* floats, __m128& x, __m128& y, __m128& z)
+{
+	auto a = _mm_loadu_ps(floats);
+	auto b = _mm_loadu_ps(floats + 4);
+	auto c = _mm_loadu_ps(floats + 8);
+	x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+#endif
+
+/* Bounding Volumes */
+void ExtendBox(Bounds& bounds, const glm::vec3* positions, size_t count)
+{
+	size_t i = 0;
+#if BOUNDS_SSE2
+	if (count >= 4)
+	{
+		// Four positions are twelve floats, three registers of x y z x | y z x y | z x y z.
+		// Each lane always sees the same axis, so the axes are only sorted out after the loop.
+		auto floats = reinterpret_cast<const float*>(positions);
+		auto min_a = _mm_loadu_ps(floats), min_b = _mm_loadu_ps(floats + 4), min_c = _mm_loadu_ps(floats + 8);
+		auto max_a = min_a, max_b = min_b, max_c = min_c;
+		for (i = 4; i + 4 <= count; i += 4)
+		{
+			auto a = _mm_loadu_ps(floats + i * 3);
+			auto b = _mm_loadu_ps(floats + i * 3 + 4);
+			auto c = _mm_loadu_ps(floats + i * 3 + 8);
+			min_a = _mm_min_ps(min_a, a);
+			min_b = _mm_min_ps(min_b, b);
+			min_c = _mm_min_ps(min_c, c);
+			max_a = _mm_max_ps(max_a, a);
+			max_b = _mm_max_ps(max_b, b);
+			max_c = _mm_max_ps(max_c, c);
+		}
+
+		alignas(16) float lanes[2][12];
+		_mm_store_ps(lanes[0], min_a);
+		_mm_store_ps(lanes[0] + 4, min_b);
+		_mm_store_ps(lanes[0] + 8, min_c);
+		_mm_store_ps(lanes[1], max_a);
+		_mm_store_ps(lanes[1] + 4, max_b);
+		_mm_store_ps(lanes[1] + 8, max_c);
+		for (int lane = 0; lane < 12; ++lane)
+		{
+			auto axis = lane % 3;
+			bounds.min[axis] = glm::min(bounds.min[axis], lanes[0][lane]);
+			bounds.max[axis] = glm::max(bounds.max[axis], lanes[1][lane]);
+		}
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		bounds.min = glm::min(bounds.min, positions[i]);
+		bounds.max = glm::max(bounds.max, positions[i]);
+	}
+}
+
+void MergeBox(Bounds& bounds, const Bounds& other)
+{
+	bounds.min = glm::min(bounds.min, other.min);
+	bounds.max = glm::max(bounds.max, other.max);
+}
+
+void FitBoundingSphere(Bounds& bounds, const glm::vec3* positions, size_t count)
+{
+	if (bounds.Empty())
+	{
+		bounds.center = glm::vec3(0);
+		bounds.radius = 0;
+		return;
+	}
+	bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+	size_t i = 0;
+	auto radius_squared = 0.f;
+#if BOUNDS_SSE2
+	if (count >= 4)
+	{
+		auto floats = reinterpret_cast<const float*>(positions);
+		auto center_x = _mm_set1_ps(bounds.center.x);
+		auto center_y = _mm_set1_ps(bounds.center.y);
+		auto center_z = _mm_set1_ps(bounds.center.z);
+		auto max_distance = _mm_setzero_ps();
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			TransposePositions(floats + i * 3, x, y, z);
+			x = _mm_sub_ps(x, center_x);
+			y = _mm_sub_ps(y, center_y);
+			z = _mm_sub_ps(z, center_z);
+			auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+			max_distance = _mm_max_ps(max_distance, distance);
+		}
+
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, max_distance);
+		radius_squared = glm::max(glm::max(lanes[0], lanes[1]), glm::max(lanes[2], lanes[3]));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		auto offset = positions[i] - bounds.center;
+		radius_squared = glm::max(radius_squared, glm::dot(offset, offset));
+	}
+	bounds.radius = glm::sqrt(radius_squared);
+}
+
+Bounds ComputeBounds(const glm::vec3* positions, size_t count)
+{
+	Bounds bounds;
+	ExtendBox(bounds, positions, count);
+	FitBoundingSphere(bounds, positions, count);
+	return bounds;
+}
+
+Bounds TransformBounds(const Bounds& bounds, const glm::mat4& transform)
+{
+	if (bounds.Empty())
+		return bounds;
+
+	// Arvo: every output axis is the translation plus the smaller or larger product of each input axis
+	Bounds transformed;
+	transformed.min = transformed.max = glm::vec3(transform[3]);
+	for (int column = 0; column < 3; ++column)
+	{
+		auto a = glm::vec3(transform[column]) * bounds.min[column];
+		auto b = glm::vec3(transform[column]) * bounds.max[column];
+		transformed.min += glm::min(a, b);
+		transformed.max += glm::max(a, b);
+	}
+
+	auto scale = glm::max(glm::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))), glm::length(glm::vec3(transform[2])));
+	transformed.center = glm::vec3(transform * glm::vec4(bounds.center, 1));
+	transformed.radius = bounds.radius * scale;
+	return transformed;
+}
+
+/* Frustum Culling */
+Frustum ExtractFrustum(const glm::mat4& clip_from_space)
+{
+	// Gribb and Hartmann: -w <= x, y, z <= w are the sums and differences of the fourth row with the others
+	auto Row = [&clip_from_space](int row)
+	{
+		return glm::vec4(clip_from_space[0][row], clip_from_space[1][row], clip_from_space[2][row], clip_from_space[3][row]);
+	};
+
+	Frustum frustum;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		frustum.planes[axis * 2] = Row(3) + Row(axis);
+		frustum.planes[axis * 2 + 1] = Row(3) - Row(axis);
+	}
+	for (auto& plane : frustum.planes)
+		plane /= glm::length(glm::vec3(plane));
+	return frustum;
+}
+
+bool SphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius)
+{
+	for (const auto& plane : frustum.planes)
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	return true;
+}
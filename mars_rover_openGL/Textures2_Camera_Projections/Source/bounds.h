@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include "GLM/glm.hpp"
+
+/* Bounding Volumes */
+// Axis aligned box and bounding sphere of a mesh, in the space of the positions it was computed from
+struct Bounds
+{
+	glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+	glm::vec3 center = glm::vec3(0);	// Of the sphere, the box center
+	float radius = 0;
+
+	bool Empty() const { return min.x > max.x; }
+};
+
+// Grows the box over the positions with SIMD min/max reductions, leaves the sphere alone
+void ExtendBox(Bounds& bounds, const glm::vec3* positions, size_t count);
+
+void MergeBox(Bounds& bounds, const Bounds& other);
+
+// Centers the sphere on the box and grows it until every position is inside, one more SIMD pass.
+// Tighter than the box's half diagonal for anything round.
+void FitBoundingSphere(Bounds& bounds, const glm::vec3* positions, size_t count);
+
+Bounds ComputeBounds(const glm::vec3* positions, size_t count);
+
+// Bounds of the transformed mesh, the box is the box around the transformed box.
+// The sphere radius grows by the largest axis scale of the transform.
+Bounds TransformBounds(const Bounds& bounds, const glm::mat4& transform);
+
+/* Frustum Culling */
+// Planes of a projection * view (* model) matrix in the space it is applied to, normals point inwards
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+Frustum ExtractFrustum(const glm::mat4& clip_from_space);
+
+// False only when the sphere is entirely outside a plane, a sphere just past a corner still passes
+bool SphereInFrustum(const Frustum& frustum, const glm::vec3& center, float radius);
@@ -1,159 +1,739 @@
-#include "extras.h"
-
-/* Generator Functions */
-void GenerateParametricShapeFrom2D(
-	std::vector<glm::vec3>& positions,
-	std::vector<glm::vec3>& normals,
-	std::vector<glm::vec2>& uvs,
-	std::vector<GLuint>& indices,
-	glm::dvec2 (*parametric_line)(double),
-	int vertical_segments,
-	int rotation_segments
-)
-{
-	auto parametric_surface = [parametric_line](double t, double r)
-	{
-		auto p = glm::dvec3(parametric_line(t), 0);
-		return glm::rotateY(p, r * glm::two_pi<double>());
-	};
-
-	positions.reserve(vertical_segments * rotation_segments);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments; ++v)
-			positions.push_back(
-				parametric_surface(v / double(vertical_segments - 1), r / double(rotation_segments - 1)));
-
-	normals.reserve(vertical_segments * rotation_segments);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments; ++v)
-		{
-			auto nv = v / double(vertical_segments - 1);
-			auto nr = r / double(rotation_segments-1);
-			auto epsilonv = 1 / double(vertical_segments - 1);
-			auto epsilonr = 1 / double(rotation_segments-1);
-
-			auto to_next_v = parametric_surface(nv + epsilonv, nr) - parametric_surface(nv, nr);
-			auto from_prev_v = parametric_surface(nv, nr) - parametric_surface(nv - epsilonv, nr);
-			auto tangent_v = (to_next_v + from_prev_v) / 2.;
-
-			auto to_next_r = parametric_surface(nv, nr + epsilonr) - parametric_surface(nv, nr);
-			auto from_prev_r = parametric_surface(nv, nr) - parametric_surface(nv, nr - epsilonr);
-			auto tangent_r = (to_next_r + from_prev_r) / 2.;
-
-			auto normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(normal);
-		}
-
-	uvs.reserve(vertical_segments * rotation_segments);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments; ++v)
-			uvs.push_back(glm::vec2(r / double(rotation_segments - 1), v / double(vertical_segments - 1)));
-
-	auto VRtoIndex = [vertical_segments, rotation_segments](int v, int r)
-	{
-		return (r % rotation_segments) * vertical_segments + v;
-	};
-	indices.reserve(rotation_segments * (vertical_segments - 1) * 6);
-	for (int r = 0; r < rotation_segments - 1; ++r)
-		for (int v = 0; v < vertical_segments - 1; ++v)
-		{
-			indices.push_back(VRtoIndex(v + 1, r));
-			indices.push_back(VRtoIndex(v, r + 1));
-			indices.push_back(VRtoIndex(v, r));
-
-			indices.push_back(VRtoIndex(v + 1, r));
-			indices.push_back(VRtoIndex(v + 1, r + 1));
-			indices.push_back(VRtoIndex(v, r + 1));
-		}
-}
-
-void GenerateParametricShapeFrom3D(
-	std::vector<glm::vec3>& positions,
-	std::vector<glm::vec3>& normals,
-	std::vector<GLuint>& indices,
-	glm::dvec3 (*parametric_surface)(double, double),
-	int vertical_segments,
-	int rotation_segments
-)
-{
-	positions.reserve(vertical_segments * rotation_segments);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments; ++v)
-			positions.push_back(parametric_surface(v / double(vertical_segments - 1), r / double(rotation_segments)));
-
-	normals.reserve(vertical_segments * rotation_segments);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments; ++v)
-		{
-			auto nv = v / double(vertical_segments - 1);
-			auto nr = r / double(rotation_segments -1);
-			auto epsilonv = 1 / double(vertical_segments - 1);
-			auto epsilonr = 1 / double(rotation_segments -1);
-
-			auto to_next_v = parametric_surface(nv + epsilonv, nr) - parametric_surface(nv, nr);
-			auto from_prev_v = parametric_surface(nv, nr) - parametric_surface(nv - epsilonv, nr);
-			auto tangent_v = (to_next_v + from_prev_v) / 2.;
-
-			auto to_next_r = parametric_surface(nv, nr + epsilonr) - parametric_surface(nv, nr);
-			auto from_prev_r = parametric_surface(nv, nr) - parametric_surface(nv, nr - epsilonr);
-			auto tangent_r = (to_next_r + from_prev_r) / 2.;
-
-			auto normal = glm::normalize(glm::cross(tangent_r, tangent_v));
-			normals.push_back(normal);
-		}
-
-	auto VRtoIndex = [vertical_segments, rotation_segments](int v, int r)
-	{
-		return (r % rotation_segments) * vertical_segments + v;
-	};
-	indices.reserve(rotation_segments * (vertical_segments - 1) * 6);
-	for (int r = 0; r < rotation_segments; ++r)
-		for (int v = 0; v < vertical_segments - 1; ++v)
-		{
-			indices.push_back(VRtoIndex(v + 1, r));
-			indices.push_back(VRtoIndex(v, r + 1));
-			indices.push_back(VRtoIndex(v, r));
-
-			indices.push_back(VRtoIndex(v + 1, r));
-			indices.push_back(VRtoIndex(v + 1, r + 1));
-			indices.push_back(VRtoIndex(v, r + 1));
-		}
-}
-
-/* Example 2D Parametric Functions */
-glm::dvec2 ParametricHalfCircle(double t)
-{
-	// [0, 1]
-	t -= 0.5;
-	// [-0.5, 0.5]
-	t *= glm::pi<double>();
-	// [-PI*0.5, PI*0.5]
-	return glm::dvec2(cos(t), sin(t));
-};
-
-glm::dvec2 ParametricCircle(double t)
-{
-	// [0, 1]
-	t -= 0.5;
-	// [-0.5, 0.5]
-	t *= glm::two_pi<double>();
-	// [-PI, PI]
-
-	auto c = glm::dvec2(0.7, 0);
-	auto r = 0.25;
-	return glm::dvec2(cos(t), sin(t)) * r + c;
-};
-
-glm::dvec2 ParametricSpikes(double t)
-{
-	// [0, 1]
-	t -= 0.5;
-	// [-0.5, 0.5]
-	t *= glm::two_pi<double>();
-	// [-PI, PI]
-
-	auto c = glm::dvec2(0.5, 0);
-	auto r = 0.35;
-	auto a = 2 + 4 * 4;
-	return (glm::dvec2(cos(t) + sin(a * t) / a, sin(t) + cos(a * t) / a) / 2.) * r + c;
-};
+#include "extras.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EXTRAS_SSE2 1
+#else
+#define EXTRAS_SSE2 0
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define EXTRAS_AVX2 1
+#else
+#define EXTRAS_AVX2 0
+#endif
+
+/* Threading Helpers */
+namespace
+{
+	// One ParallelFor call, split into ranges that the calling thread and any idle pool worker claim one at a time
+	struct ParallelJob
+	{
+		const std::function<void(int, int)>* body;
+		int count;
+		int ranges;
+		std::atomic<int> next_range{ 0 };
+		int finished_ranges = 0;	// Guarded by the pool's mutex
+	};
+
+	// Started on the first parallel call and kept for the rest of the process, so a generator that calls
+	// ParallelFor a few times per mesh doesn't pay for starting and joining threads every time. Callers run their
+	// own ranges too, so a ParallelFor inside a ParallelFor or on a busy pool still finishes, just with less help.
+	struct WorkerPool
+	{
+		std::mutex mutex;
+		std::condition_variable wake;		// Workers, a job was added
+		std::condition_variable finished;	// Callers, a job's last range finished
+		std::deque<std::shared_ptr<ParallelJob>> jobs;
+		std::vector<std::thread> workers;
+
+		explicit WorkerPool(int thread_count)
+		{
+			for (int i = 0; i < thread_count; ++i)
+				workers.emplace_back([this] { Work(); });
+		}
+
+		// Claims and runs one range, false when every range is claimed
+		bool RunRange(ParallelJob& job)
+		{
+			auto range = job.next_range++;
+			if (range >= job.ranges)
+				return false;
+			(*job.body)(int(int64_t(job.count) * range / job.ranges), int(int64_t(job.count) * (range + 1) / job.ranges));
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (++job.finished_ranges == job.ranges)
+				finished.notify_all();
+			return true;
+		}
+
+		void Run(const std::shared_ptr<ParallelJob>& job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.push_back(job);
+			}
+			wake.notify_all();
+
+			while (RunRange(*job))
+				;
+
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&job] { return job->finished_ranges == job->ranges; });
+			auto found = std::find(jobs.begin(), jobs.end(), job);
+			if (found != jobs.end())
+				jobs.erase(found);
+		}
+
+		void Work()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				wake.wait(lock, [this] { return !jobs.empty(); });
+
+				// A job stays queued until it has no ranges left to claim
+				auto job = jobs.front();
+				lock.unlock();
+				auto ran = RunRange(*job);
+				lock.lock();
+				if (!ran && !jobs.empty() && jobs.front() == job)
+					jobs.pop_front();
+			}
+		}
+	};
+
+	WorkerPool& Pool()
+	{
+		// Never destroyed, workers may still wait on it while the process exits
+		static auto pool = new WorkerPool(glm::max(int(std::thread::hardware_concurrency()) - 1, 1));
+		return *pool;
+	}
+}
+
+void ParallelFor(int count, int thread_count, const std::function<void(int, int)>& body)
+{
+	if (thread_count <= 0)
+		thread_count = int(std::thread::hardware_concurrency());
+	thread_count = glm::clamp(thread_count, 1, glm::max(count, 1));
+
+	if (thread_count == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	auto job = std::make_shared<ParallelJob>();
+	job->body = &body;
+	job->count = count;
+	job->ranges = thread_count;
+	Pool().Run(job);
+}
+
+/* Grid Helpers */
+void GenerateGridUVs(std::vector<glm::vec2>& uvs, int vertical_segments, int rotation_segments, int thread_count)
+{
+	uvs.resize(vertical_segments * rotation_segments);
+	GenerateGridUVs(uvs.data(), vertical_segments, rotation_segments, thread_count);
+}
+
+void GenerateGridUVs(glm::vec2* uvs, int vertical_segments, int rotation_segments, int thread_count)
+{
+	ParallelFor(rotation_segments, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			for (int v = 0; v < vertical_segments; ++v)
+				uvs[r * vertical_segments + v] = glm::vec2(r / double(rotation_segments - 1), v / double(vertical_segments - 1));
+	});
+}
+
+size_t GridIndexCount(int vertical_segments, int columns, Topology topology)
+{
+	if (columns <= 0)
+		return 0;
+	if (topology == Topology::TriangleStrips)
+		return size_t(columns) * (vertical_segments * 2 + 1) - 1;
+	return size_t(columns) * (vertical_segments - 1) * 6;
+}
+
+void GenerateGridIndices(
+	std::vector<GLuint>& indices,
+	int vertical_segments,
+	int rotation_segments,
+	int columns,
+	Topology topology,
+	int thread_count
+)
+{
+	indices.resize(GridIndexCount(vertical_segments, columns, topology));
+	GenerateGridIndices(indices.data(), vertical_segments, rotation_segments, columns, topology, thread_count);
+}
+
+void GenerateGridIndices(
+	GLuint* indices,
+	int vertical_segments,
+	int rotation_segments,
+	int columns,
+	Topology topology,
+	int thread_count
+)
+{
+	auto VRtoIndex = [vertical_segments, rotation_segments](int v, int r)
+	{
+		return GLuint((r % rotation_segments) * vertical_segments + v);
+	};
+
+	if (topology == Topology::TriangleStrips)
+	{
+		// (v, r + 1), (v, r) zigzag up the column keeps the winding of the triangle list,
+		// each column ends in a restart index except the last one
+		auto strip_length = vertical_segments * 2 + 1;
+		ParallelFor(columns, thread_count, [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+			{
+				auto strip = &indices[r * strip_length];
+				for (int v = 0; v < vertical_segments; ++v)
+				{
+					strip[v * 2] = VRtoIndex(v, r + 1);
+					strip[v * 2 + 1] = VRtoIndex(v, r);
+				}
+				if (r != columns - 1)
+					strip[strip_length - 1] = primitive_restart_index;
+			}
+		});
+		return;
+	}
+
+	ParallelFor(columns, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			for (int v = 0; v < vertical_segments - 1; ++v)
+			{
+				auto quad = &indices[(r * (vertical_segments - 1) + v) * 6];
+				quad[0] = VRtoIndex(v + 1, r);
+				quad[1] = VRtoIndex(v, r + 1);
+				quad[2] = VRtoIndex(v, r);
+
+				quad[3] = VRtoIndex(v + 1, r);
+				quad[4] = VRtoIndex(v + 1, r + 1);
+				quad[5] = VRtoIndex(v, r + 1);
+			}
+	});
+}
+
+void GenerateGridNormals(
+	const std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	int vertical_segments,
+	int rotation_segments,
+	bool duplicated_seam,
+	int thread_count
+)
+{
+	auto P = [&positions, vertical_segments](int v, int r)
+	{
+		return glm::dvec3(positions[r * vertical_segments + v]);
+	};
+	auto columns = duplicated_seam ? rotation_segments - 1 : rotation_segments;
+	auto tangent_r_at = [&P, columns](int v, int r)
+	{
+		auto prev_r = (r + columns - 1) % columns;
+		auto next_r = (r + 1) % columns;
+		return (P(v, next_r) - P(v, prev_r)) / 2.;
+	};
+
+	normals.resize(vertical_segments * rotation_segments);
+	ParallelFor(rotation_segments, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			for (int v = 0; v < vertical_segments; ++v)
+			{
+				auto prev_v = glm::max(v - 1, 0);
+				auto next_v = glm::min(v + 1, vertical_segments - 1);
+				auto tangent_v = (P(next_v, r) - P(prev_v, r)) / double(next_v - prev_v);
+
+				// A collapsed ring (the poles) has no rotation tangent, borrow the one of the neighbouring ring
+				auto tangent_r = tangent_r_at(v, r);
+				if (glm::length(tangent_r) < 1e-12)
+					tangent_r = tangent_r_at(v == 0 ? next_v : prev_v, r);
+
+				normals[r * vertical_segments + v] = glm::normalize(glm::cross(tangent_r, tangent_v));
+			}
+	});
+}
+
+/* Surface of Revolution Helpers */
+void TabulateRotation(RevolutionTables& tables, int rotation_segments)
+{
+	tables.cosines.resize(rotation_segments);
+	tables.sines.resize(rotation_segments);
+	for (int r = 0; r < rotation_segments; ++r)
+	{
+		auto angle = r / double(rotation_segments - 1) * glm::two_pi<double>();
+		tables.cosines[r] = cos(angle);
+		tables.sines[r] = sin(angle);
+	}
+}
+
+Bounds RevolveProfile(std::vector<glm::vec3>& out, const RevolutionTables& tables, int thread_count)
+{
+	out.resize(tables.x.size() * tables.cosines.size());
+	return RevolveProfile(out.data(), tables, thread_count);
+}
+
+Bounds RevolveProfile(glm::vec3* out, const RevolutionTables& tables, int thread_count)
+{
+	auto vertical_segments = int(tables.x.size());
+	auto rotation_segments = int(tables.cosines.size());
+
+	ParallelFor(rotation_segments, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			auto c = tables.cosines[r];
+			auto s = tables.sines[r];
+			auto column = out + r * vertical_segments;
+
+			int v = 0;
+#if EXTRAS_SSE2
+			auto cc = _mm_set1_pd(c);
+			auto ss = _mm_set1_pd(s);
+			auto zero_c = _mm_set1_pd(0. * c);
+			auto zero_s = _mm_set1_pd(0. * s);
+			auto sign = _mm_set1_pd(-0.);
+			for (; v + 2 <= vertical_segments; v += 2)
+			{
+				auto x = _mm_loadu_pd(&tables.x[v]);
+				alignas(16) float rx[4], ry[4], rz[4];
+				_mm_store_ps(rx, _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(x, cc), zero_s)));
+				_mm_store_ps(ry, _mm_cvtpd_ps(_mm_loadu_pd(&tables.y[v])));
+				_mm_store_ps(rz, _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_xor_pd(x, sign), ss), zero_c)));
+
+				column[v] = glm::vec3(rx[0], ry[0], rz[0]);
+				column[v + 1] = glm::vec3(rx[1], ry[1], rz[1]);
+			}
+#endif
+			for (; v < vertical_segments; ++v)
+			{
+				auto x = tables.x[v];
+				column[v] = glm::dvec3(x * c + 0. * s, tables.y[v], -x * s + 0. * c);
+			}
+		}
+	});
+
+	// out may be write-only mapped memory, so the box comes from the tables instead of the written vectors
+	return RevolutionBox(tables);
+}
+
+Bounds RevolutionBox(const RevolutionTables& tables)
+{
+	// Each column is linear in the profile's x, so its extremes are the ones of the smallest and largest x,
+	// computed with the same expressions as RevolveProfile and rounded the same way, the box is exact
+	auto vertical_segments = int(tables.x.size());
+	auto rotation_segments = int(tables.cosines.size());
+	Bounds bounds;
+	if (vertical_segments == 0 || rotation_segments == 0)
+		return bounds;
+	auto x_range = std::minmax_element(tables.x.begin(), tables.x.end());
+	auto y_range = std::minmax_element(tables.y.begin(), tables.y.end());
+	for (int r = 0; r < rotation_segments; ++r)
+	{
+		auto c = tables.cosines[r];
+		auto s = tables.sines[r];
+		for (auto x : { *x_range.first, *x_range.second })
+		{
+			auto p = glm::vec3(glm::dvec3(x * c + 0. * s, *y_range.first, -x * s + 0. * c));
+			bounds.min = glm::min(bounds.min, p);
+			bounds.max = glm::max(bounds.max, p);
+		}
+	}
+	bounds.min.y = float(*y_range.first);
+	bounds.max.y = float(*y_range.second);
+	return bounds;
+}
+
+void FitBoundingSphere(Bounds& bounds, const RevolutionTables& tables, int thread_count)
+{
+	if (bounds.Empty())
+	{
+		bounds.center = glm::vec3(0);
+		bounds.radius = 0;
+		return;
+	}
+	bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+	// Recomputes every vertex exactly like RevolveProfile instead of reading them back
+	auto vertical_segments = int(tables.x.size());
+	auto rotation_segments = int(tables.cosines.size());
+	std::vector<float> column_radius_squared(rotation_segments);
+	ParallelFor(rotation_segments, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			auto c = tables.cosines[r];
+			auto s = tables.sines[r];
+			auto radius_squared = 0.f;
+			for (int v = 0; v < vertical_segments; ++v)
+			{
+				auto x = tables.x[v];
+				auto offset = glm::vec3(glm::dvec3(x * c + 0. * s, tables.y[v], -x * s + 0. * c)) - bounds.center;
+				radius_squared = glm::max(radius_squared, glm::dot(offset, offset));
+			}
+			column_radius_squared[r] = radius_squared;
+		}
+	});
+	bounds.radius = glm::sqrt(*std::max_element(column_radius_squared.begin(), column_radius_squared.end()));
+}
+
+/* Generator Functions */
+static void(*BatchVersionOf(glm::dvec2(*parametric_line)(double)))(const double*, glm::dvec2*, int)
+{
+	if (parametric_line == ParametricHalfCircle)
+		return ParametricHalfCircleBatch;
+	if (parametric_line == ParametricCircle)
+		return ParametricCircleBatch;
+	if (parametric_line == ParametricSpikes)
+		return ParametricSpikesBatch;
+	return nullptr;
+}
+
+// The explicit template arguments pick the templated generators in generators.h over these overloads
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	glm::dvec2 (*parametric_line)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	if (auto batch = BatchVersionOf(parametric_line))
+		return GenerateParametricShapeFrom2D<BatchParametricLine>(
+			positions, normals, uvs, indices, BatchParametricLine{ parametric_line, batch }, vertical_segments, rotation_segments, options);
+	else
+		return GenerateParametricShapeFrom2D<decltype(parametric_line)>(
+			positions, normals, uvs, indices, parametric_line, vertical_segments, rotation_segments, options);
+}
+
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	glm::dvec2 (*parametric_line)(double),
+	glm::dvec2 (*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	if (auto batch = BatchVersionOf(parametric_line))
+		return GenerateParametricShapeFrom2D<BatchParametricLine, decltype(parametric_line_derivative)>(
+			positions, normals, uvs, indices, BatchParametricLine{ parametric_line, batch }, parametric_line_derivative,
+			vertical_segments, rotation_segments, options);
+	else
+		return GenerateParametricShapeFrom2D<decltype(parametric_line), decltype(parametric_line_derivative)>(
+			positions, normals, uvs, indices, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+}
+
+Bounds GenerateParametricShapeFrom2D(
+	const MeshSink& sink,
+	glm::dvec2 (*parametric_line)(double),
+	glm::dvec2 (*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	if (auto batch = BatchVersionOf(parametric_line))
+		return GenerateParametricShapeFrom2D<BatchParametricLine, decltype(parametric_line_derivative)>(
+			sink, BatchParametricLine{ parametric_line, batch }, parametric_line_derivative, vertical_segments, rotation_segments, options);
+	else
+		return GenerateParametricShapeFrom2D<decltype(parametric_line), decltype(parametric_line_derivative)>(
+			sink, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+}
+
+Bounds GenerateParametricShapeFrom3D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<GLuint>& indices,
+	glm::dvec3 (*parametric_surface)(double, double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	return GenerateParametricShapeFrom3D<decltype(parametric_surface)>(
+		positions, normals, indices, parametric_surface, vertical_segments, rotation_segments, options);
+}
+
+/* Example 2D Parametric Functions */
+glm::dvec2 ParametricHalfCircle(double t)
+{
+	// [0, 1]
+	t -= 0.5;
+	// [-0.5, 0.5]
+	t *= glm::pi<double>();
+	// [-PI*0.5, PI*0.5]
+	return glm::dvec2(cos(t), sin(t));
+};
+
+glm::dvec2 ParametricCircle(double t)
+{
+	// [0, 1]
+	t -= 0.5;
+	// [-0.5, 0.5]
+	t *= glm::two_pi<double>();
+	// [-PI, PI]
+
+	auto c = glm::dvec2(parametric_circle_center, 0);
+	auto r = parametric_circle_radius;
+	return glm::dvec2(cos(t), sin(t)) * r + c;
+};
+
+glm::dvec2 ParametricSpikes(double t)
+{
+	// [0, 1]
+	t -= 0.5;
+	// [-0.5, 0.5]
+	t *= glm::two_pi<double>();
+	// [-PI, PI]
+
+	auto c = glm::dvec2(parametric_spikes_center, 0);
+	auto r = parametric_spikes_radius;
+	auto a = parametric_spikes_count;
+	return (glm::dvec2(cos(t) + sin(a * t) / a, sin(t) + cos(a * t) / a) / 2.) * r + c;
+};
+
+/* Derivatives of the Example 2D Parametric Functions, d/dt */
+glm::dvec2 ParametricHalfCircleDerivative(double t)
+{
+	t -= 0.5;
+	t *= glm::pi<double>();
+	return glm::dvec2(-sin(t), cos(t)) * glm::pi<double>();
+};
+
+glm::dvec2 ParametricCircleDerivative(double t)
+{
+	t -= 0.5;
+	t *= glm::two_pi<double>();
+
+	auto r = parametric_circle_radius;
+	return glm::dvec2(-sin(t), cos(t)) * r * glm::two_pi<double>();
+};
+
+glm::dvec2 ParametricSpikesDerivative(double t)
+{
+	t -= 0.5;
+	t *= glm::two_pi<double>();
+
+	auto r = parametric_spikes_radius;
+	auto a = parametric_spikes_count;
+	return (glm::dvec2(-sin(t) + cos(a * t), cos(t) - sin(a * t)) / 2.) * r * glm::two_pi<double>();
+};
+
+/* Vectorized Math */
+// sin and cos of every lane: Cody-Waite reduction by PI/2 followed by the fdlibm kernel polynomials on
+// [-PI/4, PI/4]. Within a couple of ulps of the C library for the arguments the profiles use (|x| < 1e5).
+namespace
+{
+	const double two_over_pi = 6.36619772367581382433e-01;
+	const double pio2_1 = 1.57079632673412561417e+00;
+	const double pio2_2 = 6.07710050630396597660e-11;
+	const double pio2_3 = 2.02226624871116645580e-21;
+	const double round_magic = 6755399441055744.0;	// 1.5 * 2^52, adding it rounds to an integer in the low bits
+
+	const double S1 = -1.66666666666666324348e-01, S2 = 8.33333333332248946124e-03, S3 = -1.98412698298579493134e-04;
+	const double S4 = 2.75573137070700676789e-06, S5 = -2.50507602534068634195e-08, S6 = 1.58969099521155010221e-10;
+	const double C1 = 4.16666666666666019037e-02, C2 = -1.38888888888741095749e-03, C3 = 2.48015872894767294178e-05;
+	const double C4 = -2.75573143513906633035e-07, C5 = 2.08757232129817482790e-09, C6 = -1.13596475577881948265e-11;
+}
+
+#if EXTRAS_SSE2
+static void SinCos(__m128d x, __m128d& sin_out, __m128d& cos_out)
+{
+	auto shifted = _mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(two_over_pi)), _mm_set1_pd(round_magic));
+	auto q = _mm_sub_pd(shifted, _mm_set1_pd(round_magic));
+	auto quadrant = _mm_castpd_si128(shifted);
+
+	auto r = _mm_sub_pd(x, _mm_mul_pd(q, _mm_set1_pd(pio2_1)));
+	r = _mm_sub_pd(r, _mm_mul_pd(q, _mm_set1_pd(pio2_2)));
+	r = _mm_sub_pd(r, _mm_mul_pd(q, _mm_set1_pd(pio2_3)));
+
+	auto z = _mm_mul_pd(r, r);
+	auto ps = _mm_add_pd(_mm_set1_pd(S5), _mm_mul_pd(z, _mm_set1_pd(S6)));
+	ps = _mm_add_pd(_mm_set1_pd(S4), _mm_mul_pd(z, ps));
+	ps = _mm_add_pd(_mm_set1_pd(S3), _mm_mul_pd(z, ps));
+	ps = _mm_add_pd(_mm_set1_pd(S2), _mm_mul_pd(z, ps));
+	ps = _mm_add_pd(_mm_set1_pd(S1), _mm_mul_pd(z, ps));
+	auto s = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(z, r), ps));
+
+	auto pc = _mm_add_pd(_mm_set1_pd(C5), _mm_mul_pd(z, _mm_set1_pd(C6)));
+	pc = _mm_add_pd(_mm_set1_pd(C4), _mm_mul_pd(z, pc));
+	pc = _mm_add_pd(_mm_set1_pd(C3), _mm_mul_pd(z, pc));
+	pc = _mm_add_pd(_mm_set1_pd(C2), _mm_mul_pd(z, pc));
+	pc = _mm_add_pd(_mm_set1_pd(C1), _mm_mul_pd(z, pc));
+	auto c = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.), _mm_mul_pd(_mm_set1_pd(0.5), z)), _mm_mul_pd(_mm_mul_pd(z, z), pc));
+
+	// Odd quadrants swap sin and cos, bit 1 of the quadrant (of quadrant + 1 for cos) flips the sign
+	auto swap = _mm_castsi128_pd(_mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(quadrant, _mm_set1_epi64x(1))));
+	auto sin_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(quadrant, _mm_set1_epi64x(2)), 62));
+	auto cos_sign = _mm_castsi128_pd(_mm_slli_epi64(_mm_and_si128(_mm_add_epi64(quadrant, _mm_set1_epi64x(1)), _mm_set1_epi64x(2)), 62));
+
+	sin_out = _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, c), _mm_andnot_pd(swap, s)), sin_sign);
+	cos_out = _mm_xor_pd(_mm_or_pd(_mm_and_pd(swap, s), _mm_andnot_pd(swap, c)), cos_sign);
+}
+#endif
+
+#if EXTRAS_AVX2
+static void SinCos(__m256d x, __m256d& sin_out, __m256d& cos_out)
+{
+	auto shifted = _mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(two_over_pi)), _mm256_set1_pd(round_magic));
+	auto q = _mm256_sub_pd(shifted, _mm256_set1_pd(round_magic));
+	auto quadrant = _mm256_castpd_si256(shifted);
+
+	auto r = _mm256_sub_pd(x, _mm256_mul_pd(q, _mm256_set1_pd(pio2_1)));
+	r = _mm256_sub_pd(r, _mm256_mul_pd(q, _mm256_set1_pd(pio2_2)));
+	r = _mm256_sub_pd(r, _mm256_mul_pd(q, _mm256_set1_pd(pio2_3)));
+
+	auto z = _mm256_mul_pd(r, r);
+	auto ps = _mm256_add_pd(_mm256_set1_pd(S5), _mm256_mul_pd(z, _mm256_set1_pd(S6)));
+	ps = _mm256_add_pd(_mm256_set1_pd(S4), _mm256_mul_pd(z, ps));
+	ps = _mm256_add_pd(_mm256_set1_pd(S3), _mm256_mul_pd(z, ps));
+	ps = _mm256_add_pd(_mm256_set1_pd(S2), _mm256_mul_pd(z, ps));
+	ps = _mm256_add_pd(_mm256_set1_pd(S1), _mm256_mul_pd(z, ps));
+	auto s = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(z, r), ps));
+
+	auto pc = _mm256_add_pd(_mm256_set1_pd(C5), _mm256_mul_pd(z, _mm256_set1_pd(C6)));
+	pc = _mm256_add_pd(_mm256_set1_pd(C4), _mm256_mul_pd(z, pc));
+	pc = _mm256_add_pd(_mm256_set1_pd(C3), _mm256_mul_pd(z, pc));
+	pc = _mm256_add_pd(_mm256_set1_pd(C2), _mm256_mul_pd(z, pc));
+	pc = _mm256_add_pd(_mm256_set1_pd(C1), _mm256_mul_pd(z, pc));
+	auto c = _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(_mm256_set1_pd(0.5), z)), _mm256_mul_pd(_mm256_mul_pd(z, z), pc));
+
+	auto swap = _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_setzero_si256(), _mm256_and_si256(quadrant, _mm256_set1_epi64x(1))));
+	auto sin_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(quadrant, _mm256_set1_epi64x(2)), 62));
+	auto cos_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(quadrant, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(2)), 62));
+
+	sin_out = _mm256_xor_pd(_mm256_blendv_pd(s, c, swap), sin_sign);
+	cos_out = _mm256_xor_pd(_mm256_blendv_pd(c, s, swap), cos_sign);
+}
+#endif
+
+/* Batch Versions of the Example 2D Parametric Functions */
+// Each one runs the widest available loop, the narrower loops and finally the scalar function pick up the rest.
+// The arithmetic mirrors the scalar versions above operation for operation.
+void ParametricHalfCircleBatch(const double* t, glm::dvec2* out, int count)
+{
+	int i = 0;
+#if EXTRAS_AVX2
+	for (; i + 4 <= count; i += 4)
+	{
+		auto x = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(t + i), _mm256_set1_pd(0.5)), _mm256_set1_pd(glm::pi<double>()));
+		__m256d s, c;
+		SinCos(x, s, c);
+
+		alignas(32) double xs[4], ys[4];
+		_mm256_store_pd(xs, c);
+		_mm256_store_pd(ys, s);
+		for (int k = 0; k < 4; ++k)
+			out[i + k] = glm::dvec2(xs[k], ys[k]);
+	}
+#endif
+#if EXTRAS_SSE2
+	for (; i + 2 <= count; i += 2)
+	{
+		auto x = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(t + i), _mm_set1_pd(0.5)), _mm_set1_pd(glm::pi<double>()));
+		__m128d s, c;
+		SinCos(x, s, c);
+
+		_mm_storeu_pd(&out[i].x, _mm_unpacklo_pd(c, s));
+		_mm_storeu_pd(&out[i + 1].x, _mm_unpackhi_pd(c, s));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = ParametricHalfCircle(t[i]);
+}
+
+void ParametricCircleBatch(const double* t, glm::dvec2* out, int count)
+{
+	int i = 0;
+#if EXTRAS_AVX2
+	for (; i + 4 <= count; i += 4)
+	{
+		auto x = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(t + i), _mm256_set1_pd(0.5)), _mm256_set1_pd(glm::two_pi<double>()));
+		__m256d s, c;
+		SinCos(x, s, c);
+
+		auto r = _mm256_set1_pd(parametric_circle_radius);
+		alignas(32) double xs[4], ys[4];
+		_mm256_store_pd(xs, _mm256_add_pd(_mm256_mul_pd(c, r), _mm256_set1_pd(parametric_circle_center)));
+		_mm256_store_pd(ys, _mm256_add_pd(_mm256_mul_pd(s, r), _mm256_set1_pd(0.)));
+		for (int k = 0; k < 4; ++k)
+			out[i + k] = glm::dvec2(xs[k], ys[k]);
+	}
+#endif
+#if EXTRAS_SSE2
+	for (; i + 2 <= count; i += 2)
+	{
+		auto x = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(t + i), _mm_set1_pd(0.5)), _mm_set1_pd(glm::two_pi<double>()));
+		__m128d s, c;
+		SinCos(x, s, c);
+
+		auto r = _mm_set1_pd(parametric_circle_radius);
+		auto px = _mm_add_pd(_mm_mul_pd(c, r), _mm_set1_pd(parametric_circle_center));
+		auto py = _mm_add_pd(_mm_mul_pd(s, r), _mm_set1_pd(0.));
+		_mm_storeu_pd(&out[i].x, _mm_unpacklo_pd(px, py));
+		_mm_storeu_pd(&out[i + 1].x, _mm_unpackhi_pd(px, py));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = ParametricCircle(t[i]);
+}
+
+void ParametricSpikesBatch(const double* t, glm::dvec2* out, int count)
+{
+	const double a = parametric_spikes_count;
+	int i = 0;
+#if EXTRAS_AVX2
+	for (; i + 4 <= count; i += 4)
+	{
+		auto x = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(t + i), _mm256_set1_pd(0.5)), _mm256_set1_pd(glm::two_pi<double>()));
+		__m256d s, c, sa, ca;
+		SinCos(x, s, c);
+		SinCos(_mm256_mul_pd(_mm256_set1_pd(a), x), sa, ca);
+
+		auto aa = _mm256_set1_pd(a);
+		auto half = _mm256_set1_pd(2.);
+		auto r = _mm256_set1_pd(parametric_spikes_radius);
+		auto px = _mm256_div_pd(_mm256_add_pd(c, _mm256_div_pd(sa, aa)), half);
+		auto py = _mm256_div_pd(_mm256_add_pd(s, _mm256_div_pd(ca, aa)), half);
+
+		alignas(32) double xs[4], ys[4];
+		_mm256_store_pd(xs, _mm256_add_pd(_mm256_mul_pd(px, r), _mm256_set1_pd(parametric_spikes_center)));
+		_mm256_store_pd(ys, _mm256_add_pd(_mm256_mul_pd(py, r), _mm256_set1_pd(0.)));
+		for (int k = 0; k < 4; ++k)
+			out[i + k] = glm::dvec2(xs[k], ys[k]);
+	}
+#endif
+#if EXTRAS_SSE2
+	for (; i + 2 <= count; i += 2)
+	{
+		auto x = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(t + i), _mm_set1_pd(0.5)), _mm_set1_pd(glm::two_pi<double>()));
+		__m128d s, c, sa, ca;
+		SinCos(x, s, c);
+		SinCos(_mm_mul_pd(_mm_set1_pd(a), x), sa, ca);
+
+		auto aa = _mm_set1_pd(a);
+		auto half = _mm_set1_pd(2.);
+		auto r = _mm_set1_pd(parametric_spikes_radius);
+		auto px = _mm_add_pd(_mm_mul_pd(_mm_div_pd(_mm_add_pd(c, _mm_div_pd(sa, aa)), half), r), _mm_set1_pd(parametric_spikes_center));
+		auto py = _mm_add_pd(_mm_mul_pd(_mm_div_pd(_mm_add_pd(s, _mm_div_pd(ca, aa)), half), r), _mm_set1_pd(0.));
+		_mm_storeu_pd(&out[i].x, _mm_unpacklo_pd(px, py));
+		_mm_storeu_pd(&out[i + 1].x, _mm_unpackhi_pd(px, py));
+	}
+#endif
+	for (; i < count; ++i)
+		out[i] = ParametricSpikes(t[i]);
+}
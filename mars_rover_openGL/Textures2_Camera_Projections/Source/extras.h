@@ -1,33 +1,91 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-#include "GLM/glm.hpp"
-#include "GLM/gtc/constants.hpp"
-#include "GLM/gtx/rotate_vector.hpp"
-#include "GLAD/glad.h"
-
-/* Generator Functions */
-void GenerateParametricShapeFrom2D(
-	std::vector<glm::vec3>& positions,
-	std::vector<glm::vec3>& normals,
-	std::vector<glm::vec2>& uvs,
-	std::vector<GLuint>& indices,
-	glm::dvec2(*parametric_line)(double),
-	int vertical_segments,
-	int rotation_segments
-);
-
-void GenerateParametricShapeFrom3D(
-	std::vector<glm::vec3>& positions,
-	std::vector<glm::vec3>& normals,
-	std::vector<GLuint>& indices,
-	glm::dvec3(*parametric_surface)(double, double),
-	int vertical_segments,
-	int rotation_segments
-);
-
-/* Example 2D Parametric Functions */
-glm::dvec2 ParametricHalfCircle(double);
-glm::dvec2 ParametricCircle(double);
-glm::dvec2 ParametricSpikes(double);
\ No newline at end of file
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLM/gtc/constants.hpp"
+#include "GLM/gtx/rotate_vector.hpp"
+#include "GLAD/glad.h"
+
+#include "generators.h"
+
+/* Generator Functions */
+// Function pointer versions of the templated generators in generators.h, they return the bounds of the positions
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	glm::dvec2(*parametric_line)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
+
+// Same as above, but each normal comes straight from the derivative of the profile
+// instead of eight extra evaluations of the surface
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
+
+// Same, written into sink, see MeshSink in generators.h
+Bounds GenerateParametricShapeFrom2D(
+	const MeshSink& sink,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
+
+Bounds GenerateParametricShapeFrom3D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<GLuint>& indices,
+	glm::dvec3(*parametric_surface)(double, double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
+
+/* Example 2D Parametric Functions */
+// Shapes of the profiles below, shared by their derivatives, batch versions and the GLSL versions in gpu_generators.cpp
+constexpr double parametric_circle_radius = 0.25;
+constexpr double parametric_circle_center = 0.7;	// On the x axis
+constexpr double parametric_spikes_radius = 0.35;
+constexpr double parametric_spikes_center = 0.5;
+constexpr int parametric_spikes_count = 2 + 4 * 4;
+
+glm::dvec2 ParametricHalfCircle(double);
+glm::dvec2 ParametricCircle(double);
+glm::dvec2 ParametricSpikes(double);
+
+/* Derivatives of the Example 2D Parametric Functions */
+glm::dvec2 ParametricHalfCircleDerivative(double);
+glm::dvec2 ParametricCircleDerivative(double);
+glm::dvec2 ParametricSpikesDerivative(double);
+
+/* Batch Versions of the Example 2D Parametric Functions */
+// Evaluate count values of t at once, four lanes with AVX2, two with SSE2, one by one otherwise.
+// The generators above pick these up automatically for the matching scalar functions.
+void ParametricHalfCircleBatch(const double* t, glm::dvec2* out, int count);
+void ParametricCircleBatch(const double* t, glm::dvec2* out, int count);
+void ParametricSpikesBatch(const double* t, glm::dvec2* out, int count);
+
+// A scalar profile paired with its batch version, callable both ways so TabulateProfile can detect it
+struct BatchParametricLine
+{
+	glm::dvec2(*scalar)(double);
+	void(*batch)(const double*, glm::dvec2*, int);
+
+	glm::dvec2 operator()(double t) const { return scalar(t); }
+	void operator()(const double* t, glm::dvec2* out, int count) const { batch(t, out, count); }
+};
\ No newline at end of file
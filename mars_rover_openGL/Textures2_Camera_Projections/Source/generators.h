@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLM/gtc/constants.hpp"
+#include "GLM/gtx/rotate_vector.hpp"
+#include "GLAD/glad.h"
+
+#include "adaptive_sampling.h"
+#include "bounds.h"
+
+/*
+	Header-only generators that take any callable as the profile or surface, so plain functions and
+	lambdas get inlined into the hot loops and lambdas can capture their parameters. The helpers that do
+	not depend on the callable are compiled once in extras.cpp. extras.h keeps the function pointer API.
+*/
+
+/* Generator Options */
+enum class NormalMode
+{
+	FiniteDifference,	// Evaluate the surface again around every vertex
+	Grid				// Central differences over the generated positions, no extra evaluations
+};
+
+enum class Topology
+{
+	Triangles,		// GL_TRIANGLES, 6 indices per grid quad
+	TriangleStrips	// GL_TRIANGLE_STRIP, one strip per rotation column separated by primitive_restart_index
+};
+
+// Restart index of GL_PRIMITIVE_RESTART for GLuint indices, see VAO::Bind. VAO narrows it to 0xFFFF with GLushort indices.
+constexpr GLuint primitive_restart_index = 0xFFFFFFFF;
+
+struct GeneratorOptions
+{
+	NormalMode normal_mode = NormalMode::FiniteDifference;
+	Topology topology = Topology::Triangles;
+	int thread_count = 1;	// Rotation rows are split across this many threads, 0 uses every core
+};
+
+// Part of every mesh cache key of their output, bump it whenever the generators or the example profiles in
+// extras.cpp produce different meshes
+constexpr uint32_t generator_revision = 1;
+
+// Where a generator writes its output when it shouldn't allocate it, e.g. buffers mapped with glMapBufferRange.
+// The arrays have to hold the vertex and index counts of the mesh, the generator only writes to them.
+struct MeshSink
+{
+	glm::vec3* positions;
+	glm::vec3* normals;
+	glm::vec2* uvs;
+	GLuint* indices;
+};
+
+/* Threading Helpers */
+// Splits [0, count) into one contiguous range per thread and waits for all of them. The calling thread and the
+// workers of a pool kept for the whole process run the ranges, no threads are started per call.
+void ParallelFor(int count, int thread_count, const std::function<void(int begin, int end)>& body);
+
+/* Grid Helpers */
+void GenerateGridUVs(std::vector<glm::vec2>& uvs, int vertical_segments, int rotation_segments, int thread_count);
+void GenerateGridUVs(glm::vec2* uvs, int vertical_segments, int rotation_segments, int thread_count);
+
+size_t GridIndexCount(int vertical_segments, int columns, Topology topology);
+
+// Two triangles per grid quad, or two strip indices per quad with Topology::TriangleStrips.
+// Columns past the last rotation segment wrap around to the first one.
+void GenerateGridIndices(
+	std::vector<GLuint>& indices,
+	int vertical_segments,
+	int rotation_segments,
+	int columns,
+	Topology topology,
+	int thread_count
+);
+void GenerateGridIndices(
+	GLuint* indices,
+	int vertical_segments,
+	int rotation_segments,
+	int columns,
+	Topology topology,
+	int thread_count
+);
+
+// Central differences over the already generated position grid, one-sided at the first and last rows.
+// With a duplicated seam the last column is the first one, so the neighbours across it skip it.
+void GenerateGridNormals(
+	const std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	int vertical_segments,
+	int rotation_segments,
+	bool duplicated_seam,
+	int thread_count
+);
+
+/* Surface of Revolution Helpers */
+// Every vertex of a surface of revolution is rotateY(vec3(profile(t), 0), angle), where the profile only depends
+// on v and the angle only on r. Both are tabulated once, O(V + R) trig instead of O(V * R), and combined here.
+struct RevolutionTables
+{
+	std::vector<double> x, y;			// Profile, one entry per vertical segment
+	std::vector<double> cosines, sines;	// Rotation, one entry per rotation segment
+};
+
+
+void TabulateRotation(RevolutionTables& tables, int rotation_segments);
+
+// Profiles that can also be called as profile(const double* t, glm::dvec2* out, int count) are evaluated
+// through that batch version, see BatchParametricLine in extras.h. Pass 0 as the last argument.
+template <typename ParametricLine>
+auto TabulateProfile(RevolutionTables& tables, const ParametricLine& parametric_line, int vertical_segments, int)
+	-> decltype(parametric_line(static_cast<const double*>(nullptr), static_cast<glm::dvec2*>(nullptr), 0), void())
+{
+	std::vector<double> t(vertical_segments);
+	std::vector<glm::dvec2> p(vertical_segments);
+	for (int v = 0; v < vertical_segments; ++v)
+		t[v] = v / double(vertical_segments - 1);
+	parametric_line(t.data(), p.data(), vertical_segments);
+
+	tables.x.resize(vertical_segments);
+	tables.y.resize(vertical_segments);
+	for (int v = 0; v < vertical_segments; ++v)
+	{
+		tables.x[v] = p[v].x;
+		tables.y[v] = p[v].y;
+	}
+}
+
+template <typename ParametricLine>
+void TabulateProfile(RevolutionTables& tables, const ParametricLine& parametric_line, int vertical_segments, long)
+{
+	tables.x.resize(vertical_segments);
+	tables.y.resize(vertical_segments);
+	for (int v = 0; v < vertical_segments; ++v)
+	{
+		auto p = parametric_line(v / double(vertical_segments - 1));
+		tables.x[v] = p.x;
+		tables.y[v] = p.y;
+	}
+}
+
+// Outer product of the profile and rotation tables, the expressions match glm::rotateY bit for bit.
+// Returns the box of the written vectors, derived from the tables without reading them back.
+Bounds RevolveProfile(std::vector<glm::vec3>& out, const RevolutionTables& tables, int thread_count);
+Bounds RevolveProfile(glm::vec3* out, const RevolutionTables& tables, int thread_count);
+
+// Box of the positions RevolveProfile writes from these tables, O(V + R)
+Bounds RevolutionBox(const RevolutionTables& tables);
+
+// FitBoundingSphere for the positions RevolveProfile writes from these tables, without reading them back
+void FitBoundingSphere(Bounds& bounds, const RevolutionTables& tables, int thread_count);
+
+// Evaluates the surface around every vertex, eight extra calls per normal
+template <typename Surface>
+void GenerateFiniteDifferenceNormals(
+	std::vector<glm::vec3>& normals,
+	const Surface& parametric_surface,
+	int vertical_segments,
+	int rotation_segments,
+	int thread_count
+)
+{
+	normals.resize(vertical_segments * rotation_segments);
+	ParallelFor(rotation_segments, thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			for (int v = 0; v < vertical_segments; ++v)
+			{
+				auto nv = v / double(vertical_segments - 1);
+				auto nr = r / double(rotation_segments-1);
+				auto epsilonv = 1 / double(vertical_segments - 1);
+				auto epsilonr = 1 / double(rotation_segments-1);
+
+				auto to_next_v = parametric_surface(nv + epsilonv, nr) - parametric_surface(nv, nr);
+				auto from_prev_v = parametric_surface(nv, nr) - parametric_surface(nv - epsilonv, nr);
+				auto tangent_v = (to_next_v + from_prev_v) / 2.;
+
+				auto to_next_r = parametric_surface(nv, nr + epsilonr) - parametric_surface(nv, nr);
+				auto from_prev_r = parametric_surface(nv, nr) - parametric_surface(nv, nr - epsilonr);
+				auto tangent_r = (to_next_r + from_prev_r) / 2.;
+
+				normals[r * vertical_segments + v] = glm::normalize(glm::cross(tangent_r, tangent_v));
+			}
+	});
+}
+
+/* Generator Functions */
+// Every generator returns the box and bounding sphere of the positions it wrote
+template <typename ParametricLine>
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const ParametricLine& parametric_line,
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+)
+{
+	auto parametric_surface = [&parametric_line](double t, double r)
+	{
+		auto p = glm::dvec3(parametric_line(t), 0);
+		return glm::rotateY(p, r * glm::two_pi<double>());
+	};
+
+	RevolutionTables tables;
+	TabulateProfile(tables, parametric_line, vertical_segments, 0);
+	TabulateRotation(tables, rotation_segments);
+	auto bounds = RevolveProfile(positions, tables, options.thread_count);
+
+	if (options.normal_mode == NormalMode::Grid)
+		GenerateGridNormals(positions, normals, vertical_segments, rotation_segments, true, options.thread_count);
+	else
+		GenerateFiniteDifferenceNormals(normals, parametric_surface, vertical_segments, rotation_segments, options.thread_count);
+
+	GenerateGridUVs(uvs, vertical_segments, rotation_segments, options.thread_count);
+	GenerateGridIndices(indices, vertical_segments, rotation_segments, rotation_segments - 1, options.topology, options.thread_count);
+
+	FitBoundingSphere(bounds, positions.data(), positions.size());
+	return bounds;
+}
+
+template <typename ParametricLine, typename ParametricLineDerivative>
+Bounds GenerateParametricShapeFrom2D(
+	const MeshSink& sink,
+	const ParametricLine& parametric_line,
+	const ParametricLineDerivative& parametric_line_derivative,
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+)
+{
+	RevolutionTables position_tables, normal_tables;
+	TabulateProfile(position_tables, parametric_line, vertical_segments, 0);
+	normal_tables.x.resize(vertical_segments);
+	normal_tables.y.resize(vertical_segments);
+	for (int v = 0; v < vertical_segments; ++v)
+	{
+		auto p = glm::dvec2(position_tables.x[v], position_tables.y[v]);
+		auto d = parametric_line_derivative(v / double(vertical_segments - 1));
+
+		// cross(tangent_r, tangent_v) reduces to the 2D profile normal rotated around Y,
+		// the length of tangent_r (2*PI*p.x) only flips the sign when p.x is negative
+		auto n = glm::normalize(glm::dvec2(d.y, -d.x)) * (p.x < 0 ? -1. : 1.);
+		normal_tables.x[v] = n.x;
+		normal_tables.y[v] = n.y;
+	}
+	TabulateRotation(position_tables, rotation_segments);
+	normal_tables.cosines = position_tables.cosines;
+	normal_tables.sines = position_tables.sines;
+
+	// Nothing below reads the sink, every array is written once, front to back within each thread's range
+	auto bounds = RevolveProfile(sink.positions, position_tables, options.thread_count);
+	RevolveProfile(sink.normals, normal_tables, options.thread_count);
+
+	GenerateGridUVs(sink.uvs, vertical_segments, rotation_segments, options.thread_count);
+	GenerateGridIndices(sink.indices, vertical_segments, rotation_segments, rotation_segments - 1, options.topology, options.thread_count);
+
+	FitBoundingSphere(bounds, position_tables, options.thread_count);
+	return bounds;
+}
+
+template <typename ParametricLine, typename ParametricLineDerivative>
+Bounds GenerateParametricShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const ParametricLine& parametric_line,
+	const ParametricLineDerivative& parametric_line_derivative,
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+)
+{
+	positions.resize(vertical_segments * rotation_segments);
+	normals.resize(vertical_segments * rotation_segments);
+	uvs.resize(vertical_segments * rotation_segments);
+	indices.resize(GridIndexCount(vertical_segments, rotation_segments - 1, options.topology));
+	return GenerateParametricShapeFrom2D(
+		MeshSink{ positions.data(), normals.data(), uvs.data(), indices.data() },
+		parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+}
+
+template <typename ParametricSurface>
+Bounds GenerateParametricShapeFrom3D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<GLuint>& indices,
+	const ParametricSurface& parametric_surface,
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+)
+{
+	positions.resize(vertical_segments * rotation_segments);
+	std::vector<Bounds> row_bounds(rotation_segments);
+	ParallelFor(rotation_segments, options.thread_count, [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			for (int v = 0; v < vertical_segments; ++v)
+				positions[r * vertical_segments + v] =
+					parametric_surface(v / double(vertical_segments - 1), r / double(rotation_segments));
+			ExtendBox(row_bounds[r], &positions[r * vertical_segments], vertical_segments);
+		}
+	});
+
+	Bounds bounds;
+	for (const auto& row : row_bounds)
+		MergeBox(bounds, row);
+
+	if (options.normal_mode == NormalMode::Grid)
+		GenerateGridNormals(positions, normals, vertical_segments, rotation_segments, false, options.thread_count);
+	else
+		GenerateFiniteDifferenceNormals(normals, parametric_surface, vertical_segments, rotation_segments, options.thread_count);
+
+	GenerateGridIndices(indices, vertical_segments, rotation_segments, rotation_segments, options.topology, options.thread_count);
+
+	FitBoundingSphere(bounds, positions.data(), positions.size());
+	return bounds;
+}
+
+// Surface of revolution over AdaptiveProfileSamples. Every ring uses the same t values, so the grid stays a
+// tensor product and neighbouring columns share their edges, no cracks to stitch. uv.y is t itself.
+// The normals always come from the position grid, the finite differences assume uniformly spaced t.
+template <typename ParametricLine>
+Bounds GenerateAdaptiveShapeFrom2D(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const ParametricLine& parametric_line,
+	double tolerance,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+)
+{
+	auto samples = AdaptiveProfileSamples(parametric_line, tolerance);
+	auto vertical_segments = int(samples.size());
+
+	RevolutionTables tables;
+	tables.x.resize(vertical_segments);
+	tables.y.resize(vertical_segments);
+	for (int v = 0; v < vertical_segments; ++v)
+	{
+		auto p = glm::dvec2(parametric_line(samples[v]));
+		tables.x[v] = p.x;
+		tables.y[v] = p.y;
+	}
+	TabulateRotation(tables, rotation_segments);
+	auto bounds = RevolveProfile(positions, tables, options.thread_count);
+
+	GenerateGridNormals(positions, normals, vertical_segments, rotation_segments, true, options.thread_count);
+
+	uvs.resize(vertical_segments * rotation_segments);
+	for (int r = 0; r < rotation_segments; ++r)
+		for (int v = 0; v < vertical_segments; ++v)
+			uvs[r * vertical_segments + v] = glm::vec2(r / double(rotation_segments - 1), samples[v]);
+
+	GenerateGridIndices(indices, vertical_segments, rotation_segments, rotation_segments - 1, options.topology, options.thread_count);
+
+	FitBoundingSphere(bounds, positions.data(), positions.size());
+	return bounds;
+}
@@ -0,0 +1,383 @@
+#include "gpu_generators.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* GLSL Versions of the Example Profiles */
+// Each defines vec2 Profile(float t) and vec2 ProfileDerivative(float t), the same as the C++ functions. Their
+// constants are #defined from the ones in extras.h, see ProfileDefines.
+struct GLSLProfile
+{
+	glm::dvec2(*parametric_line)(double);
+	glm::dvec2(*parametric_line_derivative)(double);
+	const char* source;
+};
+
+static const GLSLProfile glsl_profiles[] = {
+	{ ParametricHalfCircle, ParametricHalfCircleDerivative, R"GLSL(
+		vec2 Profile(float t)
+		{
+			float a = (t - 0.5) * PI;
+			return vec2(cos(a), sin(a));
+		}
+		vec2 ProfileDerivative(float t)
+		{
+			float a = (t - 0.5) * PI;
+			return vec2(-sin(a), cos(a)) * PI;
+		}
+	)GLSL" },
+	{ ParametricCircle, ParametricCircleDerivative, R"GLSL(
+		vec2 Profile(float t)
+		{
+			float a = (t - 0.5) * 2 * PI;
+			return vec2(cos(a), sin(a)) * CIRCLE_RADIUS + vec2(CIRCLE_CENTER, 0);
+		}
+		vec2 ProfileDerivative(float t)
+		{
+			float a = (t - 0.5) * 2 * PI;
+			return vec2(-sin(a), cos(a)) * CIRCLE_RADIUS * 2 * PI;
+		}
+	)GLSL" },
+	{ ParametricSpikes, ParametricSpikesDerivative, R"GLSL(
+		const float spikes = SPIKES_COUNT;
+		vec2 Profile(float t)
+		{
+			float a = (t - 0.5) * 2 * PI;
+			return vec2(cos(a) + sin(spikes * a) / spikes, sin(a) + cos(spikes * a) / spikes) / 2 * SPIKES_RADIUS + vec2(SPIKES_CENTER, 0);
+		}
+		vec2 ProfileDerivative(float t)
+		{
+			float a = (t - 0.5) * 2 * PI;
+			return vec2(-sin(a) + cos(spikes * a), cos(a) - sin(spikes * a)) / 2 * SPIKES_RADIUS * 2 * PI;
+		}
+	)GLSL" },
+};
+
+static const char* FindGLSLProfile(glm::dvec2(*parametric_line)(double), glm::dvec2(*parametric_line_derivative)(double))
+{
+	for (const auto& profile : glsl_profiles)
+		if (profile.parametric_line == parametric_line && profile.parametric_line_derivative == parametric_line_derivative)
+			return profile.source;
+	return nullptr;
+}
+
+/* Compute Shaders */
+static std::string ComputeShaderHeader()
+{
+	// glad only loads GL 3.3 core, the compute entry points come from the extensions even on newer contexts.
+	// Buffer bindings are set with glShaderStorageBlockBinding, layout(binding) would need GLSL 4.20.
+	if (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3))
+		return "#version 430 core\n";
+	return
+		"#version 330 core\n"
+		"#extension GL_ARB_compute_shader : require\n"
+		"#extension GL_ARB_shader_storage_buffer_object : require\n";
+}
+
+// One invocation per vertex. Mirrors TabulateRotation, RevolveProfile, GenerateGridUVs and GenerateGridIndices.
+static const char* vertex_shader_body = R"GLSL(
+	layout(local_size_x = 64) in;
+	layout(std430) writeonly buffer Positions { float positions[]; };
+	layout(std430) writeonly buffer Normals { float normals[]; };
+	layout(std430) writeonly buffer UVs { float uvs[]; };
+	layout(std430) writeonly buffer Indices { uint indices[]; };
+
+	uniform int u_vertical_segments;
+	uniform int u_rotation_segments;
+	uniform bool u_strips;
+	uniform bool u_derivative_normals;
+
+	uint VRtoIndex(int v, int r)
+	{
+		return uint((r % u_rotation_segments) * u_vertical_segments + v);
+	}
+
+	void main()
+	{
+		int id = int(gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x);
+		if (id >= u_vertical_segments * u_rotation_segments)
+			return;
+		int r = id / u_vertical_segments;
+		int v = id % u_vertical_segments;
+
+		float t = float(v) / float(u_vertical_segments - 1);
+		float angle = float(r) / float(u_rotation_segments - 1) * 2 * PI;
+		float c = cos(angle);
+		float s = sin(angle);
+
+		// Single precision puts the poles a few 1e-8 off the axis, possibly on the negative side.
+		// The C++ profiles land on the positive side there, so the sign test has some slack.
+		vec2 p = Profile(t);
+		positions[id * 3] = p.x * c;
+		positions[id * 3 + 1] = p.y;
+		positions[id * 3 + 2] = -p.x * s;
+		if (u_derivative_normals)
+		{
+			vec2 d = ProfileDerivative(t);
+			vec2 n = normalize(vec2(d.y, -d.x)) * (p.x < -1e-6 ? -1 : 1);
+			normals[id * 3] = n.x * c;
+			normals[id * 3 + 1] = n.y;
+			normals[id * 3 + 2] = -n.x * s;
+		}
+		uvs[id * 2] = float(r) / float(u_rotation_segments - 1);
+		uvs[id * 2 + 1] = t;
+
+		// The duplicated seam column starts no quads
+		int columns = u_rotation_segments - 1;
+		if (r >= columns)
+			return;
+		if (u_strips)
+		{
+			int strip_length = u_vertical_segments * 2 + 1;
+			int strip = r * strip_length;
+			indices[strip + v * 2] = VRtoIndex(v, r + 1);
+			indices[strip + v * 2 + 1] = VRtoIndex(v, r);
+			if (v == u_vertical_segments - 1 && r != columns - 1)
+				indices[strip + strip_length - 1] = 0xFFFFFFFFu;
+		}
+		else if (v < u_vertical_segments - 1)
+		{
+			int quad = (r * (u_vertical_segments - 1) + v) * 6;
+			indices[quad] = VRtoIndex(v + 1, r);
+			indices[quad + 1] = VRtoIndex(v, r + 1);
+			indices[quad + 2] = VRtoIndex(v, r);
+
+			indices[quad + 3] = VRtoIndex(v + 1, r);
+			indices[quad + 4] = VRtoIndex(v + 1, r + 1);
+			indices[quad + 5] = VRtoIndex(v, r + 1);
+		}
+	}
+)GLSL";
+
+// GenerateGridNormals with a duplicated seam, after the vertex pass
+static const char* grid_normal_shader_body = R"GLSL(
+	layout(local_size_x = 64) in;
+	layout(std430) readonly buffer Positions { float positions[]; };
+	layout(std430) writeonly buffer Normals { float normals[]; };
+
+	uniform int u_vertical_segments;
+	uniform int u_rotation_segments;
+
+	vec3 P(int v, int r)
+	{
+		int i = (r * u_vertical_segments + v) * 3;
+		return vec3(positions[i], positions[i + 1], positions[i + 2]);
+	}
+
+	vec3 TangentR(int v, int r)
+	{
+		int columns = u_rotation_segments - 1;
+		return (P(v, (r + 1) % columns) - P(v, (r + columns - 1) % columns)) / 2;
+	}
+
+	void main()
+	{
+		int id = int(gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x);
+		if (id >= u_vertical_segments * u_rotation_segments)
+			return;
+		int r = id / u_vertical_segments;
+		int v = id % u_vertical_segments;
+
+		int prev_v = max(v - 1, 0);
+		int next_v = min(v + 1, u_vertical_segments - 1);
+		vec3 tangent_v = (P(next_v, r) - P(prev_v, r)) / float(next_v - prev_v);
+
+		// The CPU's absolute 1e-12 is below single precision, the pole rings here are about 1e-8 wide
+		vec3 tangent_r = TangentR(v, r);
+		if (length(tangent_r) < 1e-4 * length(tangent_v))
+			tangent_r = TangentR(v == 0 ? next_v : prev_v, r);
+
+		vec3 n = normalize(cross(tangent_r, tangent_v));
+		normals[id * 3] = n.x;
+		normals[id * 3 + 1] = n.y;
+		normals[id * 3 + 2] = n.z;
+	}
+)GLSL";
+
+static std::string ProfileDefines()
+{
+	std::ostringstream defines;
+	defines << std::showpoint << std::setprecision(17);
+	defines << "#define CIRCLE_RADIUS " << parametric_circle_radius << "\n";
+	defines << "#define CIRCLE_CENTER " << parametric_circle_center << "\n";
+	defines << "#define SPIKES_RADIUS " << parametric_spikes_radius << "\n";
+	defines << "#define SPIKES_CENTER " << parametric_spikes_center << "\n";
+	defines << "#define SPIKES_COUNT " << double(parametric_spikes_count) << "\n";
+	return defines.str();
+}
+
+static GLuint CreateGenerationProgram(const char* profile_source, const char* body)
+{
+	auto source = ComputeShaderHeader() + ProfileDefines() + "const float PI = 3.14159265358979;\n" + profile_source + body;
+	return CreateComputeProgramFromSource(source.c_str());
+}
+
+static void BindStorageBuffer(GLuint program, const char* block, GLuint binding, GLuint buffer)
+{
+	auto index = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, block);
+	if (index == GL_INVALID_INDEX)
+		return;
+	glShaderStorageBlockBinding(program, index, binding);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+}
+
+// One invocation per vertex. Past 65535 groups the rows of a second dimension take over.
+static void DispatchPerVertex(size_t vertex_count)
+{
+	auto groups = GLuint((vertex_count + 63) / 64);
+	auto groups_x = std::min<GLuint>(groups, 65535);
+	auto groups_y = (groups + groups_x - 1) / groups_x;
+	glDispatchCompute(groups_x, groups_y, 1);
+}
+
+/* GPU Generation */
+bool GPUGenerationSupported()
+{
+	return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object
+		&& GLAD_GL_ARB_program_interface_query && GLAD_GL_ARB_shader_image_load_store;
+}
+
+// The box is exact, see RevolutionBox. The sphere is centered on it and bounds every ring by its profile point
+// plus the center's distance from the axis, tight for full revolutions, which are centered on the axis.
+static Bounds RevolutionBounds(glm::dvec2(*parametric_line)(double), int vertical_segments, int rotation_segments)
+{
+	RevolutionTables tables;
+	TabulateProfile(tables, parametric_line, vertical_segments, 0);
+	TabulateRotation(tables, rotation_segments);
+	auto bounds = RevolutionBox(tables);
+	if (bounds.Empty())
+		return bounds;
+
+	bounds.center = (bounds.min + bounds.max) * 0.5f;
+	auto center_off_axis = glm::length(glm::vec2(bounds.center.x, bounds.center.z));
+	auto radius_squared = 0.f;
+	for (int v = 0; v < vertical_segments; ++v)
+	{
+		auto horizontal = float(glm::abs(tables.x[v])) + center_off_axis;
+		auto vertical = float(tables.y[v]) - bounds.center.y;
+		radius_squared = glm::max(radius_squared, horizontal * horizontal + vertical * vertical);
+	}
+	bounds.radius = glm::sqrt(radius_squared);
+	return bounds;
+}
+
+VAO GenerateParametricShapeFrom2DGPU(
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	auto vertex_count = size_t(vertical_segments) * rotation_segments;
+	auto index_count = GridIndexCount(vertical_segments, rotation_segments - 1, options.topology);
+	auto primitive_type = GLenum(options.topology == Topology::TriangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES);
+	auto grid_normals = options.normal_mode == NormalMode::Grid;
+
+	auto profile_source = FindGLSLProfile(parametric_line, parametric_line_derivative);
+	auto vertex_program = profile_source && GPUGenerationSupported() ? CreateGenerationProgram(profile_source, vertex_shader_body) : 0;
+	auto normal_program = vertex_program && grid_normals ? CreateGenerationProgram(profile_source, grid_normal_shader_body) : 0;
+	if (!vertex_program || (grid_normals && !normal_program))
+	{
+		std::cout << "Generating on the CPU, no compute shaders or no GLSL version of the profile" << std::endl;
+		glDeleteProgram(vertex_program);
+		if (grid_normals)
+		{
+			// Grid normals read the positions back, mapped buffers can't be read
+			std::vector<glm::vec3> positions, normals;
+			std::vector<glm::vec2> uvs;
+			std::vector<GLuint> indices;
+			auto bounds = GenerateParametricShapeFrom2D(positions, normals, uvs, indices, parametric_line, vertical_segments, rotation_segments, options);
+			return VAO(positions, normals, uvs, indices, VertexFormat::Separate, primitive_type, bounds);
+		}
+		return MappedVAO(vertex_count, index_count, [&](const MeshSink& sink)
+		{
+			return GenerateParametricShapeFrom2D(sink, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+		}, primitive_type);
+	}
+
+	VAO vao(vertex_count, index_count, primitive_type);
+
+	glUseProgram(vertex_program);
+	BindStorageBuffer(vertex_program, "Positions", 0, vao.position_buffer);
+	BindStorageBuffer(vertex_program, "Normals", 1, vao.normals_buffer);
+	BindStorageBuffer(vertex_program, "UVs", 2, vao.uv_buffer);
+	BindStorageBuffer(vertex_program, "Indices", 3, vao.element_array_buffer);
+	glUniform1i(glGetUniformLocation(vertex_program, "u_vertical_segments"), vertical_segments);
+	glUniform1i(glGetUniformLocation(vertex_program, "u_rotation_segments"), rotation_segments);
+	glUniform1i(glGetUniformLocation(vertex_program, "u_strips"), options.topology == Topology::TriangleStrips);
+	glUniform1i(glGetUniformLocation(vertex_program, "u_derivative_normals"), !grid_normals);
+	DispatchPerVertex(vertex_count);
+
+	if (grid_normals)
+	{
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		glUseProgram(normal_program);
+		BindStorageBuffer(normal_program, "Positions", 0, vao.position_buffer);
+		BindStorageBuffer(normal_program, "Normals", 1, vao.normals_buffer);
+		glUniform1i(glGetUniformLocation(normal_program, "u_vertical_segments"), vertical_segments);
+		glUniform1i(glGetUniformLocation(normal_program, "u_rotation_segments"), rotation_segments);
+		DispatchPerVertex(vertex_count);
+	}
+
+	// Drawn from, and maybe read back by CompareWithCPUGeneration
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	glUseProgram(0);
+	glDeleteProgram(vertex_program);
+	glDeleteProgram(normal_program);
+
+	vao.bounds = RevolutionBounds(parametric_line, vertical_segments, rotation_segments);
+	return vao;
+}
+
+GenerationComparison CompareWithCPUGeneration(
+	const VAO& vao,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options
+)
+{
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+	if (options.normal_mode == NormalMode::Grid)
+		GenerateParametricShapeFrom2D(positions, normals, uvs, indices, parametric_line, vertical_segments, rotation_segments, options);
+	else
+		GenerateParametricShapeFrom2D(positions, normals, uvs, indices, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+
+	GenerationComparison comparison;
+	if (vao.vertex_format != VertexFormat::Separate || vao.index_type != GL_UNSIGNED_INT
+		|| size_t(vao.vertex_count) != positions.size() || size_t(vao.element_array_count) != indices.size())
+	{
+		comparison.index_mismatches = indices.size();
+		return comparison;
+	}
+
+	auto Read = [](GLuint buffer, void* out, size_t size)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, GLsizeiptr(size), out);
+	};
+	std::vector<glm::vec3> gpu_positions(positions.size()), gpu_normals(normals.size());
+	std::vector<glm::vec2> gpu_uvs(uvs.size());
+	std::vector<GLuint> gpu_indices(indices.size());
+	Read(vao.position_buffer, gpu_positions.data(), gpu_positions.size() * sizeof(glm::vec3));
+	Read(vao.normals_buffer, gpu_normals.data(), gpu_normals.size() * sizeof(glm::vec3));
+	Read(vao.uv_buffer, gpu_uvs.data(), gpu_uvs.size() * sizeof(glm::vec2));
+	Read(vao.element_array_buffer, gpu_indices.data(), gpu_indices.size() * sizeof(GLuint));
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		comparison.max_position_error = glm::max(comparison.max_position_error, glm::length(gpu_positions[i] - positions[i]));
+		comparison.max_normal_error = glm::max(comparison.max_normal_error, glm::length(gpu_normals[i] - normals[i]));
+		comparison.max_uv_error = glm::max(comparison.max_uv_error, glm::length(gpu_uvs[i] - uvs[i]));
+	}
+	for (size_t i = 0; i < indices.size(); ++i)
+		comparison.index_mismatches += gpu_indices[i] != indices[i];
+	return comparison;
+}
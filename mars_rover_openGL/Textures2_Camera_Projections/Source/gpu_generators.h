@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "extras.h"
+#include "opengl_utilities.h"
+
+/*
+	Compute shader backend of GenerateParametricShapeFrom2D. Every invocation writes one vertex and the indices of
+	the grid quad it starts, straight into the buffers of a VAO bound as shader storage buffers, so nothing is
+	generated, copied or uploaded on the CPU. A function pointer can't run in a shader, so only the example
+	profiles in extras.h, which have GLSL versions, are generated on the GPU.
+*/
+
+/* GPU Generation */
+// Compute shaders, shader storage buffers and memory barriers, the ARB extensions or GL 4.3
+bool GPUGenerationSupported();
+
+// Same mesh as the CPU generators, in the VAO(vertex_count, index_count) layout. NormalMode::Grid runs a second
+// dispatch over the written positions, otherwise the normals come from the profile derivative.
+// Falls back to the CPU when GPUGenerationSupported is false or the profile has no GLSL version.
+VAO GenerateParametricShapeFrom2DGPU(
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
+
+struct GenerationComparison
+{
+	float max_position_error = 0;
+	float max_normal_error = 0;
+	float max_uv_error = 0;
+	size_t index_mismatches = 0;
+
+	// Single precision on the GPU against double precision tables on the CPU. Grid normals difference positions
+	// a fraction of a segment apart, which magnifies that a lot more. Where a profile has a cusp, its derivative
+	// vanishes and the derivative normal is rounding noise on both sides, e.g. ParametricSpikes at 33 rows.
+	bool Matches(float position_tolerance = 1e-4f, float normal_tolerance = 1e-2f) const
+	{
+		return max_position_error <= position_tolerance && max_uv_error <= position_tolerance
+			&& max_normal_error <= normal_tolerance && index_mismatches == 0;
+	}
+};
+
+// Reads the buffers of a VAO from GenerateParametricShapeFrom2DGPU back and compares them with the CPU generators
+// called with the same arguments. Validates a driver, e.g. Mesa's llvmpipe in a headless context.
+GenerationComparison CompareWithCPUGeneration(
+	const VAO& vao,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	const GeneratorOptions& options = GeneratorOptions()
+);
@@ -0,0 +1,123 @@
+#include "heightmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "stb_image.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HEIGHTMAP_SSE2 1
+#else
+#define HEIGHTMAP_SSE2 0
+#endif
+
+/* Heightmaps */
+bool LoadHeightmap(Heightmap& heightmap, const char* filename)
+{
+	// Rows from the south pole up, like the color texture and the uvs
+	stbi_set_flip_vertically_on_load(true);
+
+	int x, y, n;
+	auto texels = stbi_load_16(filename, &x, &y, &n, 1);
+	if (texels == NULL)
+	{
+		std::cout << "Heightmap " << filename << " failed to load." << std::endl;
+		std::cout << "Error: " << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	heightmap.width = x;
+	heightmap.height = y;
+	heightmap.texels.assign(texels, texels + size_t(x) * y);
+	stbi_image_free(texels);
+
+	std::cout << "Heightmap " << filename << " is loaded, X:" << x << " Y:" << y << " N:" << n << std::endl;
+	return true;
+}
+
+// The four texels around a sample, u wrapped around and v clamped to the poles
+static inline void TexelCorners(const Heightmap& heightmap, int x, int y, float corners[4])
+{
+	auto x0 = x % heightmap.width;
+	if (x0 < 0)
+		x0 += heightmap.width;
+	auto x1 = x0 + 1 == heightmap.width ? 0 : x0 + 1;
+	auto y1 = glm::min(y + 1, heightmap.height - 1);
+
+	const auto* row0 = &heightmap.texels[size_t(y) * heightmap.width];
+	const auto* row1 = &heightmap.texels[size_t(y1) * heightmap.width];
+	corners[0] = row0[x0];
+	corners[1] = row0[x1];
+	corners[2] = row1[x0];
+	corners[3] = row1[x1];
+}
+
+void SampleHeightmap(const Heightmap& heightmap, const glm::vec2* uvs, float* heights, size_t count)
+{
+	if (heightmap.Empty())
+	{
+		std::fill(heights, heights + count, 0.f);
+		return;
+	}
+
+	// Texel centers sit on half integers. The SIMD loop and the scalar tail do the same float operations in the
+	// same order, a uv gets the same height whichever of them it lands in.
+	auto width = float(heightmap.width), height = float(heightmap.height), max_y = float(heightmap.height - 1);
+	const auto to_unit = 1 / 65535.f;
+
+	size_t i = 0;
+#if HEIGHTMAP_SSE2
+	auto width4 = _mm_set1_ps(width), height4 = _mm_set1_ps(height), max_y4 = _mm_set1_ps(max_y);
+	auto half = _mm_set1_ps(0.5f), one = _mm_set1_ps(1.f), zero = _mm_setzero_ps(), to_unit4 = _mm_set1_ps(to_unit);
+	for (; i + 4 <= count; i += 4)
+	{
+		// u v u v | u v u v to u u u u and v v v v
+		auto a = _mm_loadu_ps(&uvs[i].x);
+		auto b = _mm_loadu_ps(&uvs[i + 2].x);
+		auto x = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)), width4), half);
+		auto y = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)), height4), half), zero), max_y4);
+
+		// SSE2 only truncates, which rounds negative x the wrong way
+		auto floor_x = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+		floor_x = _mm_sub_ps(floor_x, _mm_and_ps(_mm_cmplt_ps(x, floor_x), one));
+		auto floor_y = _mm_cvtepi32_ps(_mm_cvttps_epi32(y));
+		auto fraction_x = _mm_sub_ps(x, floor_x);
+		auto fraction_y = _mm_sub_ps(y, floor_y);
+
+		// No gathers before AVX2, the texel fetches are scalar
+		alignas(16) int32_t texel_x[4], texel_y[4];
+		alignas(16) float corners[4][4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(texel_x), _mm_cvttps_epi32(floor_x));
+		_mm_store_si128(reinterpret_cast<__m128i*>(texel_y), _mm_cvttps_epi32(floor_y));
+		for (int lane = 0; lane < 4; ++lane)
+		{
+			float lane_corners[4];
+			TexelCorners(heightmap, texel_x[lane], texel_y[lane], lane_corners);
+			for (int corner = 0; corner < 4; ++corner)
+				corners[corner][lane] = lane_corners[corner];
+		}
+
+		auto h00 = _mm_load_ps(corners[0]), h10 = _mm_load_ps(corners[1]);
+		auto h01 = _mm_load_ps(corners[2]), h11 = _mm_load_ps(corners[3]);
+		auto bottom = _mm_add_ps(h00, _mm_mul_ps(_mm_sub_ps(h10, h00), fraction_x));
+		auto top = _mm_add_ps(h01, _mm_mul_ps(_mm_sub_ps(h11, h01), fraction_x));
+		auto sample = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), fraction_y));
+		_mm_storeu_ps(heights + i, _mm_mul_ps(sample, to_unit4));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		auto x = uvs[i].x * width - 0.5f;
+		auto y = glm::min(glm::max(uvs[i].y * height - 0.5f, 0.f), max_y);
+		auto floor_x = std::floor(x), floor_y = std::floor(y);
+		auto fraction_x = x - floor_x, fraction_y = y - floor_y;
+
+		float corners[4];
+		TexelCorners(heightmap, int(floor_x), int(floor_y), corners);
+		auto bottom = corners[0] + (corners[1] - corners[0]) * fraction_x;
+		auto top = corners[2] + (corners[3] - corners[2]) * fraction_x;
+		heights[i] = (bottom + (top - bottom) * fraction_y) * to_unit;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GLM/glm.hpp"
+
+/* Heightmaps */
+// Equirectangular elevation raster with the mapping of the sphere uvs, u goes around from column 0 and row 0 is
+// the south pole
+struct Heightmap
+{
+	int width = 0;
+	int height = 0;
+	std::vector<uint16_t> texels;	// Row major, 0 is the lowest elevation and 65535 the highest
+
+	bool Empty() const { return texels.empty(); }
+};
+
+// Reads the first channel, or the luminance, of any image stb_image can load, through stbi_load_16 so 16 bit PNGs
+// keep their precision. 8 bit images are widened. Prints why and returns false if the file can't be read.
+bool LoadHeightmap(Heightmap& heightmap, const char* filename);
+
+// Bilinear heights in [0, 1] at uvs, u repeats and v clamps, four at a time with SSE2. 0 everywhere without texels.
+void SampleHeightmap(const Heightmap& heightmap, const glm::vec2* uvs, float* heights, size_t count);
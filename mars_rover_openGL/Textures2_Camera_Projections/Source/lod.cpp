@@ -0,0 +1,174 @@
+#include "lod.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "extras.h"
+#include "mesh_cache.h"
+#include "mesh_utilities.h"
+
+/* Level of Detail */
+LODChain GenerateRevolutionLODChain(
+	const char* name,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int min_vertical_segments,
+	int max_vertical_segments
+)
+{
+	GeneratorOptions options;
+	options.thread_count = 0;
+	auto generator = std::string("RevolutionLOD ") + name;
+
+	LODChain chain;
+	for (auto vertical_segments = min_vertical_segments; vertical_segments <= max_vertical_segments; vertical_segments *= 2)
+	{
+		auto rotation_segments = vertical_segments / 2;
+		auto key = MeshCacheKey(generator.c_str(), { generator_revision, mesh_utilities_revision }, { double(vertical_segments), double(rotation_segments) });
+
+		MeshletMesh meshlets;
+		auto vao = CachedVAO(key, [&](
+			std::vector<glm::vec3>& positions,
+			std::vector<glm::vec3>& normals,
+			std::vector<glm::vec2>& uvs,
+			std::vector<GLuint>& indices
+		)
+		{
+			auto bounds = GenerateParametricShapeFrom2D(positions, normals, uvs, indices, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+
+			WeldVertices(positions, normals, uvs, indices);
+			OptimizeVertexCache(indices, positions.size());
+			return bounds;
+		}, VertexFormat::InterleavedQuantized, GL_TRIANGLES, &meshlets);
+
+		LODLevel level{ vao, vertical_segments, rotation_segments, size_t(vao.element_array_count / 3), std::move(meshlets) };
+		chain.levels.push_back(level);
+	}
+	return chain;
+}
+
+LODChain GenerateSimplifiedLODChain(
+	const char* name,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	size_t min_triangles
+)
+{
+	GeneratorOptions options;
+	options.thread_count = 0;
+	auto generator = std::string("SimplifiedLOD ") + name;
+
+	// Generated on the first cache miss and simplified further for every coarser level that misses too. The
+	// bounds of the full mesh hold every level, their vertices are a subset of its.
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+	Bounds bounds;
+
+	// Finest first, so each level is simplified from the last one instead of from the full mesh
+	std::vector<LODLevel> levels;
+	auto target_triangles = size_t(2) * vertical_segments * rotation_segments;
+	for (auto level_segments = rotation_segments; level_segments > 0 && target_triangles >= min_triangles; level_segments /= 2, target_triangles /= 4)
+	{
+		auto finest = levels.empty();
+		auto key = MeshCacheKey(generator.c_str(), { generator_revision, mesh_utilities_revision }, { double(vertical_segments), double(rotation_segments), double(target_triangles) });
+
+		MeshletMesh meshlets;
+		auto vao = CachedVAO(key, [&](
+			std::vector<glm::vec3>& level_positions,
+			std::vector<glm::vec3>& level_normals,
+			std::vector<glm::vec2>& level_uvs,
+			std::vector<GLuint>& level_indices
+		)
+		{
+			if (indices.empty())
+			{
+				bounds = GenerateParametricShapeFrom2D(positions, normals, uvs, indices, parametric_line, parametric_line_derivative, vertical_segments, rotation_segments, options);
+				WeldVertices(positions, normals, uvs, indices);
+			}
+
+			if (!finest)
+			{
+				SimplifyOptions simplify_options;
+				simplify_options.target_triangles = target_triangles;
+				simplify_options.target_error = std::numeric_limits<float>::max();
+				SimplifyMesh(positions, normals, uvs, indices, simplify_options);
+			}
+
+			level_positions = positions;
+			level_normals = normals;
+			level_uvs = uvs;
+			level_indices = indices;
+			OptimizeVertexCache(level_indices, level_positions.size());
+			return bounds;
+		}, VertexFormat::InterleavedQuantized, GL_TRIANGLES, &meshlets);
+
+		LODLevel level{ vao, vertical_segments * level_segments / rotation_segments, level_segments, size_t(vao.element_array_count / 3), std::move(meshlets) };
+		levels.push_back(level);
+	}
+
+	LODChain chain;
+	chain.levels.assign(levels.rbegin(), levels.rend());
+	return chain;
+}
+
+LODChain GenerateSphereLODChain(SphereTessellation tessellation, int min_edge_segments, int max_edge_segments)
+{
+	auto name = tessellation == SphereTessellation::Icosphere ? "Icosphere" : "CubeSphere";
+	auto generator = std::string("SphereLOD ") + name;
+
+	LODChain chain;
+	for (auto edge_segments = min_edge_segments; edge_segments <= max_edge_segments; edge_segments *= 2)
+	{
+		auto key = MeshCacheKey(generator.c_str(), { sphere_generator_revision, mesh_utilities_revision }, { double(edge_segments) });
+
+		MeshletMesh meshlets;
+		auto vao = CachedVAO(key, [&](
+			std::vector<glm::vec3>& positions,
+			std::vector<glm::vec3>& normals,
+			std::vector<glm::vec2>& uvs,
+			std::vector<GLuint>& indices
+		)
+		{
+			auto bounds = GenerateSphere(positions, normals, uvs, indices, tessellation, edge_segments);
+			OptimizeVertexCache(indices, positions.size());
+			return bounds;
+		}, VertexFormat::InterleavedQuantized, GL_TRIANGLES, &meshlets);
+
+		auto equator_segments = SphereEquatorSegments(tessellation, edge_segments);
+		LODLevel level{ vao, equator_segments / 2, equator_segments, size_t(vao.element_array_count / 3), std::move(meshlets) };
+		chain.levels.push_back(level);
+	}
+	return chain;
+}
+
+float ProjectedSphereRadius(float distance, float radius, float fov_y, float screen_height)
+{
+	// The silhouette cone has a half angle of asin(radius / distance), its tangent is radius / sqrt(distance^2 - radius^2)
+	auto tangent_distance_squared = distance * distance - radius * radius;
+	if (tangent_distance_squared <= 0)
+		return std::numeric_limits<float>::max();
+	return radius / std::sqrt(tangent_distance_squared) / std::tan(fov_y / 2) * screen_height / 2;
+}
+
+const LODLevel& SelectLOD(LODChain& chain, float projected_radius, float target_edge_pixels, float hysteresis)
+{
+	auto last = int(chain.levels.size()) - 1;
+
+	// Level i has rotation_segments(0) * 2^i edges around the equator
+	auto wanted_segments = projected_radius * glm::two_pi<float>() / target_edge_pixels;
+	auto ideal = std::log2(glm::max(wanted_segments, 1.f) / chain.levels[0].rotation_segments);
+	auto wanted = glm::clamp(int(std::ceil(ideal)), 0, last);
+
+	// Level i covers ideal levels in (i - 1, i]
+	if (wanted > chain.current && ideal > chain.current + hysteresis)
+		chain.current = wanted;
+	else if (wanted < chain.current && ideal < chain.current - 1 - hysteresis)
+		chain.current = wanted;
+
+	return chain.levels[chain.current];
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "meshlets.h"
+#include "opengl_utilities.h"
+#include "spheres.h"
+
+/* Level of Detail */
+struct LODLevel
+{
+	VAO vao;
+	int vertical_segments;
+	int rotation_segments;	// For the other sphere tessellations the edges around the equator, vertical_segments is half that
+	size_t triangle_count;
+	MeshletMesh meshlets;	// Of the unquantized positions, built along with the mesh and cached with it
+};
+
+struct LODChain
+{
+	std::vector<LODLevel> levels;	// Coarsest first, every level doubles both segment counts
+	int current = 0;
+};
+
+// Generates every level of a surface of revolution from min_vertical_segments x min_vertical_segments / 2 up to
+// max_vertical_segments x max_vertical_segments / 2, welded, cache optimized and quantized, split into meshlets.
+// Levels are kept in the mesh cache under name, which has to identify the profile.
+LODChain GenerateRevolutionLODChain(
+	const char* name,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int min_vertical_segments,
+	int max_vertical_segments
+);
+
+// Generates a surface of revolution once at vertical_segments x rotation_segments, welded, and simplifies it into
+// every coarser level, each with a quarter of the triangles of the one above, down to min_triangles. Levels are
+// numbered like GenerateRevolutionLODChain's, a level stands in for a tessellation with rotation_segments / 2^k
+// around. Only the levels missing from the mesh cache are simplified, from the finest of those down.
+LODChain GenerateSimplifiedLODChain(
+	const char* name,
+	glm::dvec2(*parametric_line)(double),
+	glm::dvec2(*parametric_line_derivative)(double),
+	int vertical_segments,
+	int rotation_segments,
+	size_t min_triangles
+);
+
+// Same for an icosphere or cube sphere of unit radius, edge_segments doubles from min_edge_segments up to max_edge_segments
+LODChain GenerateSphereLODChain(SphereTessellation tessellation, int min_edge_segments, int max_edge_segments);
+
+// Radius in pixels of a sphere's silhouette. Goes to infinity as the eye approaches the surface.
+float ProjectedSphereRadius(float distance, float radius, float fov_y, float screen_height);
+
+// Picks the coarsest level whose rotation edges stay below target_edge_pixels at the given projected radius.
+// A level is only left once the ideal, fractional level is past it by more than hysteresis levels, so a
+// camera hovering around a switching distance doesn't make the mesh pop back and forth.
+const LODLevel& SelectLOD(LODChain& chain, float projected_radius, float target_edge_pixels = 8.f, float hysteresis = 0.25f);
@@ -1,710 +1,705 @@
-#include <iostream>
-#include <vector>
-
-#define GLM_FORCE_LEFT_HANDED
-#include "GLM/glm.hpp"
-#include "GLM/gtc/constants.hpp"
-#include "GLM/gtc/matrix_transform.hpp"
-#include "GLM/gtx/rotate_vector.hpp"
-#include "GLM/gtx/string_cast.hpp"
-#include "GLM/gtc/type_ptr.hpp"
-#include "GLAD/glad.h"
-#include "GLFW/glfw3.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
-#include "opengl_utilities.h"
-#include "extras.h"
-#define PI 3.14159265358979323846264338327950288
-/* Keep the global state inside this struct */
-static struct
-{
-	glm::dvec2 mouse_position;
-	glm::ivec2 screen_dimensions = glm::ivec2(960, 960);
-	bool w = false;
-	bool a = false;
-	bool s = false;
-	bool d = false;
-
-	bool h = false;//cam left
-	bool j = false;//cam down
-	bool k = false;//cam up
-	bool l = false;//cam right
-
-	bool u = false;//cam look up
-	bool i = false;//cam look down
-	
-	bool plus = false;//increase/decrease camera sensitivity
-	bool minus = false;
-
-	glm::vec3 eye = glm::vec3(0, 0, -10.2);
-	glm::vec3 to = glm::vec3(0, 0, 0);
-	float touches_surface= -10.02;//if the rovers are too high, lover this value
-	//I already have motion sickness from this camera settings, I genuinely do not want tilt. Topdown good old racing.
-	/*
-	auto view = glm::lookAt(
-			glm::vec3(0, 0, -10.2),
-			glm::vec3(0, 0, 0),
-			glm::vec3(0, 1, 0)
-		);
-	*/
-
-} Globals;
-
-/* GLFW Callback functions */
-static void ErrorCallback(int error, const char* description)
-{
-	std::cerr << "Error: " << description << std::endl;
-}
-
-static void CursorPositionCallback(GLFWwindow* window, double x, double y)
-{
-	Globals.mouse_position.x = x;
-	Globals.mouse_position.y = y;
-}
-
-static void WindowSizeCallback(GLFWwindow* window, int width, int height)
-{
-	Globals.screen_dimensions.x = width;
-	Globals.screen_dimensions.y = height;
-
-	glViewport(0, 0, width, height);
-}
-
-static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
-{
-	//std::cout << key <<" action: "<<action<< std::endl;
-
-	switch (key)
-	{
-	case 68:
-		Globals.d = true;
-		if (action==0)
-			Globals.d = false;
-		break;
-	case 65:
-		Globals.a = true;
-		if (action == 0)
-			Globals.a = false;
-		break;
-	case 87:
-		Globals.w = true;
-		if (action == 0)
-			Globals.w = false;
-		break;
-	case 83:
-		Globals.s = true;
-		if (action == 0)
-			Globals.s = false;
-		break;
-	case 72:
-		Globals.h = true;
-		if (action == 0)
-			Globals.h = false;
-		break;
-	case 74:
-		Globals.j = true;
-		if (action == 0)
-			Globals.j = false;
-		break;
-	case 75:
-		Globals.k = true;
-		if (action == 0)
-			Globals.k = false;
-		break;
-	case 76:
-		Globals.l = true;
-		if (action == 0)
-			Globals.l = false;
-		break;
-	case 85:
-		Globals.u = true;
-		if (action == 0)
-			Globals.u = false;
-		break;
-	case 73:
-		Globals.i = true;
-		if (action == 0)
-			Globals.i = false;
-		break;
-	case 333:
-		Globals.minus = true;
-		if (action == 0)
-			Globals.minus = false;
-		break;
-	case 334:
-		Globals.plus = true;
-		if (action == 0)
-			Globals.plus = false;
-		break;
-	default:
-		break;
-	}
-
-	
-}
-
-int main(void)
-{
-	/* Set GLFW error callback */
-	glfwSetErrorCallback(ErrorCallback);
-
-	/* Initialize the library */
-	if (!glfwInit())
-	{
-		std::cout << "Failed to initialize GLFW" << std::endl;
-		return -1;
-	}
-
-	/* Create a windowed mode window and its OpenGL context */
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
-	glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
-	GLFWwindow* window = glfwCreateWindow(
-		Globals.screen_dimensions.x, Globals.screen_dimensions.y,
-		"Hasim Sait Goktan", NULL, NULL
-	);
-	if (!window)
-	{
-		std::cout << "Failed to create GLFW window" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
-
-	/* Load OpenGL extensions with GLAD */
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
-	{
-		std::cout << "Failed to initialize GLAD" << std::endl;
-		glfwTerminate();
-		return -1;
-	}
-	glfwSetWindowPos(window, 10, 50);
-	glfwSwapInterval(2);
-
-	/* Set GLFW Callbacks */
-	glfwSetCursorPosCallback(window, CursorPositionCallback);
-	glfwSetWindowSizeCallback(window, WindowSizeCallback);
-	glfwSetKeyCallback(window, KeyCallback);
-	/* Configure OpenGL */
-	glClearColor(0, 0, 0, 0);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-	/* Creating OpenGL objects */
-	std::vector<glm::vec3> positions;
-	std::vector<glm::vec3> normals;
-	std::vector<glm::vec2> uvs;
-	std::vector<GLuint> indices;
-	GenerateParametricShapeFrom2D(positions, normals, uvs, indices, ParametricHalfCircle, 64, 32);
-	VAO sphereVAO(positions, normals, uvs, indices);
-
-	std::vector<glm::vec3> torus_positions;
-	std::vector<glm::vec3> torus_normals;
-	std::vector<glm::vec2> torus_uvs;
-	std::vector<GLuint> torus_indices;
-	GenerateParametricShapeFrom2D(torus_positions, torus_normals, torus_uvs, torus_indices, ParametricCircle, 32, 16);
-	VAO torusVAO(torus_positions, torus_normals, torus_uvs, torus_indices);
-
-	VAO cubeVAO(
-		{
-			{-0.3f, -0.5f, -0.5f},
-			{0.3f, -0.5f, -0.5f},
-			{0.3f, 0.5f, -0.5f},
-			{0.3f, 0.5f, -0.5f},
-			{-0.3f, 0.5f, -0.5f},
-			{-0.3f, -0.5f, -0.5f},
-			{-0.3f, -0.5f, 0.5f},
-			{0.3f, -0.5f, 0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{-0.3f, 0.5f, 0.5f},
-			{-0.3f, -0.5f, 0.5f},
-			{-0.3f, 0.5f, 0.5f},
-			{-0.3f, 0.5f, -0.5f},
-			{-0.3f, -0.5f, -0.5f},
-			{-0.3f, -0.5f, -0.5f},
-			{-0.3f, -0.5f, 0.5f},
-			{-0.3f, 0.5f, 0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{0.3f, 0.5f, -0.5f},
-			{0.3f, -0.5f, -0.5f},
-			{0.3f, -0.5f, -0.5f},
-			{0.3f, -0.5f, 0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{-0.3f, -0.5f, -0.5f},
-			{0.3f, -0.5f, -0.5f},
-			{0.3f, -0.5f, 0.5f},
-			{0.3f, -0.5f, 0.5f},
-			{-0.3f, -0.5f, 0.5f},
-			{-0.3f, -0.5f, -0.5f},
-			{-0.3f, 0.5f, -0.5f},
-			{0.3f, 0.5f, -0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{0.3f, 0.5f, 0.5f},
-			{-0.3f, 0.5f, 0.5f},
-			{-0.3f, 0.5f, -0.5f}
-		},
-		{
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, -1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{0.0f, 0.0f, 1.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{-1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{1.0f, 0.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, -1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f},
-			{0.0f, 1.0f, 0.0f}
-		},
-		{},
-		{
-			0, 1, 2,
-			3, 4, 5,
-			6, 7, 8,
-			9, 10, 11,
-			12, 13, 14,
-			15, 16, 17,
-			18, 19, 20,
-			21, 22, 23,
-			24, 25, 26,
-			27, 28, 29,
-			30, 31, 32,
-			33, 34, 35
-		}
-		);
-
-	stbi_set_flip_vertically_on_load(true);
-
-	auto filename = "Assets/mars_1k_color.jpg";
-	int x, y, n;
-	unsigned char* texture_data = stbi_load(filename, &x, &y, &n, 0);
-	if (texture_data == NULL)
-	{
-		std::cout << "Texture " << filename << " failed to load." << std::endl;
-		std::cout << "Error: " << stbi_failure_reason() << std::endl;
-	}
-	else
-	{
-		std::cout << "Texture " << filename << " is loaded, X:" << x << " Y:" << y << " N:" << n << std::endl;
-	}
-
-	GLuint texture;
-	glGenTextures(1, &texture);
-
-	if (x * n % 4 != 0)
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(
-		GL_TEXTURE_2D,
-		0,
-		GL_RGBA,
-		x, y, 0, n == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, texture_data
-	);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);//either here or the sphere vao has an issue.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	if (x * n % 4 != 0)
-		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-
-	stbi_image_free(texture_data);
-
-
-	GLuint program = CreateProgramFromSources(
-		R"VERTEX(
-#version 330 core
-
-layout(location = 0) in vec3 a_position;
-layout(location = 1) in vec3 a_normal;
-layout(location = 2) in vec2 a_uv;
-
-uniform mat4 u_model;
-uniform mat4 u_projection_view;
-
-out vec4 world_space_position;
-out vec3 world_space_normal;
-out vec2 vertex_uv;
-
-void main()
-{
-	world_space_position = u_model * vec4(a_position, 1);
-	world_space_normal = vec3(u_model * vec4(a_normal, 0));
-	vertex_uv = a_uv;
-
-	gl_Position = u_projection_view * world_space_position;
-}
-		)VERTEX",
-
-		R"FRAGMENT(
-#version 330 core
-
-uniform vec2 u_mouse_position;
-uniform sampler2D u_texture;
-uniform vec3 u_surface_color;
-uniform vec3 u_mars;
-
-in vec4 world_space_position;
-in vec3 world_space_normal;
-in vec2 vertex_uv;
-
-out vec4 out_color;
-
-void main()
-{
-	vec3 color = vec3(0);
-
-	vec3 surface_position = world_space_position.xyz;
-	vec3 surface_normal = normalize(world_space_normal);
-	vec2 surface_uv = vertex_uv;
-	vec3 surface_color;
-	
-	if (u_mars == vec3(1)){
-		 surface_color=  texture(u_texture, surface_uv).rgb;
-	}
-	if (u_mars == vec3(0)){
-		surface_color = u_surface_color;
-	}
-
-	vec3 ambient_color = vec3(0.7);
-	color += ambient_color * surface_color;
-
-	vec3 light_direction = normalize(vec3(-1, -1, 1));
-	vec3 to_light = -light_direction;
-
-	vec3 light_color = vec3(0.3);
-
-	float diffuse_intensity = max(0, dot(to_light, surface_normal));
-	color += diffuse_intensity * light_color * surface_color;
-
-	vec3 view_dir = vec3(0, 0, -1);	//	Because we are using an orthograpic projection, and because of the direction of the projection
-	vec3 halfway_dir = normalize(view_dir + to_light);
-	float shininess = 64;
-	float specular_intensity = max(0, dot(halfway_dir, surface_normal));
-	color += pow(specular_intensity, shininess) * light_color;
-
-	out_color = vec4(color, 1);
-}
-		)FRAGMENT");
-	if (program == NULL)
-	{
-		glfwTerminate();
-		return -1;
-	}
-	glUseProgram(program);
-
-	auto texture_location = glGetUniformLocation(program, "u_texture");
-	glUniform1i(texture_location, 0);
-
-	glActiveTexture(GL_TEXTURE0); // activate the texture unit first before binding texture
-	glBindTexture(GL_TEXTURE_2D, texture);
-
-	auto mouse_location = glGetUniformLocation(program, "u_mouse_position");
-	auto model_location = glGetUniformLocation(program, "u_model");
-	auto projection_view_location = glGetUniformLocation(program, "u_projection_view");
-	auto surface_color_location = glGetUniformLocation(program, "u_surface_color");
-	auto mars_location = glGetUniformLocation(program, "u_mars");
-	std::vector<glm::vec3> cube_positions{
-			glm::vec3(0, 0, -10.01),
-			glm::vec3(0, 0, -10.01),
-			glm::vec3(-0.05, -0.05, -10.01),
-	};
-	auto mars_x_angle = glm::radians(0.f);
-	auto mars_y_angle = glm::radians(0.f);
-
-	auto rover_1_x_angle = glm::radians(50.f);
-	auto rover_1_y_angle = glm::radians(50.f);
-	auto rover_2_x_angle = glm::radians(0.f);
-	auto rover_2_y_angle = glm::radians(0.f);
-
-	auto eye_pos = glm::vec3(0, 0, -10.2);
-	float sensitivity = 1;
-	/* Loop until the user closes the window */
-	while (!glfwWindowShouldClose(window))
-	{
-		/* Render here */
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Calculate mouse position
-		auto mouse_position = Globals.mouse_position;
-		mouse_position /= glm::dvec2(Globals.screen_dimensions);
-		mouse_position.y = 1. - mouse_position.y;
-		mouse_position = mouse_position * 2. - 1.;
-
-		glUniform2fv(mouse_location, 1, glm::value_ptr(glm::vec2(mouse_position)));
-
-
-		
-		mouse_position *= sensitivity;
-		if (Globals.h) {
-			eye_pos.x -= 0.025;
-		}
-		else if (Globals.l) {
-			eye_pos.x += 0.025;
-		}
-		if (Globals.k) {
-			eye_pos.y += 0.025;
-		}
-		else if (Globals.j) {
-			eye_pos.y -= 0.025;
-		}
-		if (Globals.u) {
-			eye_pos.z -= 0.025;
-		}
-		else if (Globals.i) {
-			eye_pos.z += 0.025;
-		}
-		if (Globals.plus) {
-			sensitivity++;
-			std::cout << "sensitivity is now " << sensitivity << std::endl;
-		}
-		else if (Globals.minus) {
-			sensitivity--;
-			std::cout << "sensitivity is now " << sensitivity << std::endl;
-		}
-		auto view = glm::lookAt(
-			eye_pos,
-			glm::vec3(mouse_position, 0),
-			glm::vec3(0, 1, 0)
-		);
-		// Draw
-		auto projection = glm::perspective(glm::radians(45.f), 1.f, 0.000001f, 100.f);
-
-		glUniformMatrix4fv(projection_view_location, 1, GL_FALSE, glm::value_ptr(projection * view));
-		const auto draw_cube = [&](glm::vec3 position,int index,glm::mat4 &mars_trans)
-		{
-			glBindVertexArray(cubeVAO.id);
-			glm::mat4 rover_transform(1.0);
-			rover_transform = glm::translate(rover_transform, position);
-			rover_transform = glm::scale(rover_transform,glm::vec3(0.01f));
-
-			if (index != 0) {
-				rover_transform =  mars_trans* rover_transform;
-			}
-
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(rover_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(1, 0, 0)));
-			glDrawElements(GL_TRIANGLES, cubeVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-
-			glBindVertexArray(torusVAO.id);
-			glm::mat4 wheel_transform(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, 1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, 1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, -1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, -1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-		};
-
-
-		
-		glBindVertexArray(sphereVAO.id);
-		auto mars = glm::vec3(1);
-
-
-		auto position = glm::vec3(0, 0, 0);
-		auto mars_transform = glm::mat4(1);
-
-		mars_transform = glm::scale(mars_transform,glm::vec3(10.f));
-		if (Globals.w) {
-			mars_x_angle += glm::radians(1.f);
-		}else if (Globals.s) {
-			mars_x_angle -= glm::radians(1.f);
-		}	
-		if (Globals.a) {
-			mars_y_angle -= glm::radians(1.f);
-		}else if (Globals.d) {
-			mars_y_angle += glm::radians(1.f);
-		}
-		
-		mars_transform=glm::rotate(mars_transform, glm::radians(mars_x_angle), glm::vec3(-1, 0, 0));
-		mars_transform = glm::rotate(mars_transform, glm::radians(mars_y_angle), glm::vec3(0, 1, 0));
-
-		glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(mars_transform));
-		glUniform3fv(surface_color_location, 1, glm::value_ptr(position * 0.5f + 0.5f));
-		glUniform3fv(mars_location, 1, glm::value_ptr(mars));
-		glDrawElements(GL_TRIANGLES, sphereVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-		
-		mars = glm::vec3(0);
-		int index = 0;
-		for (const auto& position : cube_positions) {
-			glUniform3fv(mars_location, 1, glm::value_ptr(mars));
-			glm::mat4 mars_trans = mars_transform;
-			//draw_cube(p,index,mars_trans);
-			glBindVertexArray(cubeVAO.id);
-			glm::mat4 rover_transform(1.0);
-			//chasing_pos = glm::mix(mouse_position, chasing_pos, 0.99);
-
-			if (index != 0) {
-				
-				if (index == 1) {
-					rover_transform = glm::rotate(rover_transform, glm::radians(rover_1_x_angle), glm::vec3(-1, 0, 0));
-					rover_transform = glm::rotate(rover_transform, glm::radians(rover_1_y_angle), glm::vec3(0, 1, 0));
-					auto distance_x = mars_x_angle - rover_1_x_angle;
-					if (distance_x == abs(distance_x)) {
-						rover_1_x_angle += 0.5;
-					}
-					else {
-						rover_1_x_angle -= 0.5;
-					}
-					auto distance_y = mars_y_angle - rover_1_y_angle;
-					if (distance_y == abs(distance_y)) {
-						rover_1_y_angle += 0.5;
-					}
-					else {
-						rover_1_y_angle -= 0.5;
-					}
-
-					std::cout << rover_1_x_angle << std::endl;
-					
-				}else if (index == 2) {
-					rover_transform = glm::rotate(rover_transform, glm::radians(mars_x_angle), glm::vec3(-1, 0, 0));
-					rover_transform = glm::rotate(rover_transform, glm::radians(mars_y_angle), glm::vec3(0, 1, 0));
-				}
-
-			}
-			rover_transform = glm::translate(rover_transform, position);
-			rover_transform = glm::scale(rover_transform, glm::vec3(0.01f));
-
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(rover_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(1, 0, 0)));
-			glDrawElements(GL_TRIANGLES, cubeVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-
-			glBindVertexArray(torusVAO.id);
-			glm::mat4 wheel_transform(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, 1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, 1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, -1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-			wheel_transform = glm::mat4(1.0);
-			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
-			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, -1, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
-			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
-
-			wheel_transform = rover_transform * wheel_transform;
-			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
-			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
-			glDrawElements(GL_TRIANGLES, torusVAO.element_array_count, GL_UNSIGNED_INT, NULL);
-
-
-
-			index++;
-		}
-
-		/* Swap front and back buffers */
-		glfwSwapBuffers(window);
-
-		/* Poll for and process events */
-		glfwPollEvents();
-	}
-
-	glfwTerminate();
-	return 0;
-}
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#define GLM_FORCE_LEFT_HANDED
+#include "GLM/glm.hpp"
+#include "GLM/gtc/constants.hpp"
+#include "GLM/gtc/matrix_transform.hpp"
+#include "GLM/gtx/rotate_vector.hpp"
+#include "GLM/gtx/string_cast.hpp"
+#include "GLM/gtc/type_ptr.hpp"
+#include "GLAD/glad.h"
+#include "GLFW/glfw3.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "opengl_utilities.h"
+#include "extras.h"
+#include "gpu_generators.h"
+#include "lod.h"
+#include "meshlets.h"
+#include "mesh_utilities.h"
+#include "primitives.h"
+#include "terrain.h"
+#define PI 3.14159265358979323846264338327950288
+/* Keep the global state inside this struct */
+static struct
+{
+	glm::dvec2 mouse_position;
+	glm::ivec2 screen_dimensions = glm::ivec2(960, 960);
+	bool w = false;
+	bool a = false;
+	bool s = false;
+	bool d = false;
+
+	bool h = false;//cam left
+	bool j = false;//cam down
+	bool k = false;//cam up
+	bool l = false;//cam right
+
+	bool u = false;//cam look up
+	bool i = false;//cam look down
+	
+	bool plus = false;//increase/decrease camera sensitivity
+	bool minus = false;
+
+	bool terrain = true;//t switches between the quadtree terrain and the single LOD sphere
+	bool cluster_culling = true;//c switches culling the meshlets of the LOD sphere on and off
+
+	glm::vec3 eye = glm::vec3(0, 0, -10.2);
+	glm::vec3 to = glm::vec3(0, 0, 0);
+	float touches_surface= -10.02;//if the rovers are too high, lover this value
+	//I already have motion sickness from this camera settings, I genuinely do not want tilt. Topdown good old racing.
+	/*
+	auto view = glm::lookAt(
+			glm::vec3(0, 0, -10.2),
+			glm::vec3(0, 0, 0),
+			glm::vec3(0, 1, 0)
+		);
+	*/
+
+} Globals;
+
+/* GLFW Callback functions */
+static void ErrorCallback(int error, const char* description)
+{
+	std::cerr << "Error: " << description << std::endl;
+}
+
+static void CursorPositionCallback(GLFWwindow* window, double x, double y)
+{
+	Globals.mouse_position.x = x;
+	Globals.mouse_position.y = y;
+}
+
+static void WindowSizeCallback(GLFWwindow* window, int width, int height)
+{
+	Globals.screen_dimensions.x = width;
+	Globals.screen_dimensions.y = height;
+
+	glViewport(0, 0, width, height);
+}
+
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	//std::cout << key <<" action: "<<action<< std::endl;
+
+	switch (key)
+	{
+	case 68:
+		Globals.d = true;
+		if (action==0)
+			Globals.d = false;
+		break;
+	case 65:
+		Globals.a = true;
+		if (action == 0)
+			Globals.a = false;
+		break;
+	case 87:
+		Globals.w = true;
+		if (action == 0)
+			Globals.w = false;
+		break;
+	case 83:
+		Globals.s = true;
+		if (action == 0)
+			Globals.s = false;
+		break;
+	case 72:
+		Globals.h = true;
+		if (action == 0)
+			Globals.h = false;
+		break;
+	case 74:
+		Globals.j = true;
+		if (action == 0)
+			Globals.j = false;
+		break;
+	case 75:
+		Globals.k = true;
+		if (action == 0)
+			Globals.k = false;
+		break;
+	case 76:
+		Globals.l = true;
+		if (action == 0)
+			Globals.l = false;
+		break;
+	case 85:
+		Globals.u = true;
+		if (action == 0)
+			Globals.u = false;
+		break;
+	case 73:
+		Globals.i = true;
+		if (action == 0)
+			Globals.i = false;
+		break;
+	case 333:
+		Globals.minus = true;
+		if (action == 0)
+			Globals.minus = false;
+		break;
+	case 334:
+		Globals.plus = true;
+		if (action == 0)
+			Globals.plus = false;
+		break;
+	case 84:
+		if (action == 1) {
+			Globals.terrain = !Globals.terrain;
+			std::cout << "Mars is now drawn as " << (Globals.terrain ? "the quadtree terrain" : "a LOD sphere") << std::endl;
+		}
+		break;
+	case 67:
+		if (action == 1) {
+			Globals.cluster_culling = !Globals.cluster_culling;
+			std::cout << "Meshlet culling of the LOD sphere is now " << (Globals.cluster_culling ? "on" : "off") << std::endl;
+		}
+		break;
+	default:
+		break;
+	}
+
+	
+}
+
+int main(void)
+{
+	/* Set GLFW error callback */
+	glfwSetErrorCallback(ErrorCallback);
+
+	/* Initialize the library */
+	if (!glfwInit())
+	{
+		std::cout << "Failed to initialize GLFW" << std::endl;
+		return -1;
+	}
+
+	/* Create a windowed mode window and its OpenGL context */
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+	glfwWindowHint(GLFW_TRANSPARENT_FRAMEBUFFER, GLFW_TRUE);
+	GLFWwindow* window = glfwCreateWindow(
+		Globals.screen_dimensions.x, Globals.screen_dimensions.y,
+		"Hasim Sait Goktan", NULL, NULL
+	);
+	if (!window)
+	{
+		std::cout << "Failed to create GLFW window" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	/* Make the window's context current */
+	glfwMakeContextCurrent(window);
+
+	/* Load OpenGL extensions with GLAD */
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to initialize GLAD" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	glfwSetWindowPos(window, 10, 50);
+	glfwSwapInterval(2);
+
+	/* Set GLFW Callbacks */
+	glfwSetCursorPosCallback(window, CursorPositionCallback);
+	glfwSetWindowSizeCallback(window, WindowSizeCallback);
+	glfwSetKeyCallback(window, KeyCallback);
+	/* Configure OpenGL */
+	glClearColor(0, 0, 0, 0);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	// Core since 3.1, unlike GL_PRIMITIVE_RESTART_FIXED_INDEX. VAO::Bind sets the restart index of each VAO.
+	glEnable(GL_PRIMITIVE_RESTART);
+
+	/* Creating OpenGL objects */
+	GeneratorOptions strip_options;
+	strip_options.topology = Topology::TriangleStrips;
+
+	// From 80 triangles when Mars is a dot up to 330k when the camera hugs the surface. Same error as the 1024x512
+	// surface of revolution at the top, which took 1M triangles, most of them crammed around the poles.
+	auto mars_lods = GenerateSphereLODChain(SphereTessellation::Icosphere, 2, 128);
+
+	// Triangles of the meshlets of the current level that face the camera and are on screen, refilled every frame
+	StreamedIndices mars_visible_indices;
+
+	// Chunks are built when the camera first needs them, this only sets up the quadtrees
+	Terrain mars_terrain;
+
+	// Generated by a compute shader into the VAO's buffers, or straight into the mapped buffers without one.
+	// MeshBenchmark's gpu_generators section checks the GPU against the CPU generators.
+	auto torusVAO = GenerateParametricShapeFrom2DGPU(ParametricCircle, ParametricCircleDerivative, 32, 16, strip_options);
+
+	// Rover body, 24 vertices and 36 indices built by the compiler
+	static constexpr auto rover_body = PrimitiveBox(0.3f, 0.5f, 0.5f);
+	auto cubeVAO = PrimitiveVAO(rover_body);
+
+	stbi_set_flip_vertically_on_load(true);
+
+	auto filename = "Assets/mars_1k_color.jpg";
+	int x, y, n;
+	unsigned char* texture_data = stbi_load(filename, &x, &y, &n, 0);
+	if (texture_data == NULL)
+	{
+		std::cout << "Texture " << filename << " failed to load." << std::endl;
+		std::cout << "Error: " << stbi_failure_reason() << std::endl;
+	}
+	else
+	{
+		std::cout << "Texture " << filename << " is loaded, X:" << x << " Y:" << y << " N:" << n << std::endl;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+
+	if (x * n % 4 != 0)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(
+		GL_TEXTURE_2D,
+		0,
+		GL_RGBA,
+		x, y, 0, n == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, texture_data
+	);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);//either here or the sphere vao has an issue.
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	if (x * n % 4 != 0)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	stbi_image_free(texture_data);
+
+	// Displaces the terrain chunks. The brightness of the color map stands in for elevation, unless a real
+	// elevation map, a 16 bit equirectangular PNG like MOLA's, is dropped in next to it.
+	const char* elevation_filename = "Assets/mars_elevation.png";
+	Heightmap mars_heightmap;
+	if (!std::ifstream(elevation_filename) || !LoadHeightmap(mars_heightmap, elevation_filename))
+		LoadHeightmap(mars_heightmap, filename);
+	mars_terrain.heightmap = &mars_heightmap;
+
+	GLuint program = CreateProgramFromSources(
+		R"VERTEX(
+#version 330 core
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec3 a_normal;
+layout(location = 2) in vec2 a_uv;
+layout(location = 3) in vec3 a_morph_position;
+
+uniform mat4 u_model;
+uniform mat4 u_projection_view;
+uniform vec3 u_morph_camera;
+uniform vec2 u_morph_range;
+
+out vec4 world_space_position;
+out vec3 world_space_normal;
+out vec2 vertex_uv;
+
+void main()
+{
+	// Terrain chunks slide onto their parent's surface between u_morph_range.x and .y away from the camera
+	vec3 position = a_position;
+	if (u_morph_range.y > u_morph_range.x)
+	{
+		float morph = clamp((distance(a_position, u_morph_camera) - u_morph_range.x) / (u_morph_range.y - u_morph_range.x), 0, 1);
+		position = mix(a_position, a_morph_position, morph);
+	}
+
+	world_space_position = u_model * vec4(position, 1);
+	world_space_normal = vec3(u_model * vec4(a_normal, 0));
+	vertex_uv = a_uv;
+
+	gl_Position = u_projection_view * world_space_position;
+}
+		)VERTEX",
+
+		R"FRAGMENT(
+#version 330 core
+
+uniform vec2 u_mouse_position;
+uniform sampler2D u_texture;
+uniform vec3 u_surface_color;
+uniform vec3 u_mars;
+
+in vec4 world_space_position;
+in vec3 world_space_normal;
+in vec2 vertex_uv;
+
+out vec4 out_color;
+
+void main()
+{
+	vec3 color = vec3(0);
+
+	vec3 surface_position = world_space_position.xyz;
+	vec3 surface_normal = normalize(world_space_normal);
+	vec2 surface_uv = vertex_uv;
+	vec3 surface_color;
+	
+	if (u_mars == vec3(1)){
+		 surface_color=  texture(u_texture, surface_uv).rgb;
+	}
+	if (u_mars == vec3(0)){
+		surface_color = u_surface_color;
+	}
+
+	vec3 ambient_color = vec3(0.7);
+	color += ambient_color * surface_color;
+
+	vec3 light_direction = normalize(vec3(-1, -1, 1));
+	vec3 to_light = -light_direction;
+
+	vec3 light_color = vec3(0.3);
+
+	float diffuse_intensity = max(0, dot(to_light, surface_normal));
+	color += diffuse_intensity * light_color * surface_color;
+
+	vec3 view_dir = vec3(0, 0, -1);	//	Because we are using an orthograpic projection, and because of the direction of the projection
+	vec3 halfway_dir = normalize(view_dir + to_light);
+	float shininess = 64;
+	float specular_intensity = max(0, dot(halfway_dir, surface_normal));
+	color += pow(specular_intensity, shininess) * light_color;
+
+	out_color = vec4(color, 1);
+}
+		)FRAGMENT");
+	if (program == NULL)
+	{
+		glfwTerminate();
+		return -1;
+	}
+	glUseProgram(program);
+
+	auto texture_location = glGetUniformLocation(program, "u_texture");
+	glUniform1i(texture_location, 0);
+
+	glActiveTexture(GL_TEXTURE0); // activate the texture unit first before binding texture
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	auto mouse_location = glGetUniformLocation(program, "u_mouse_position");
+	auto model_location = glGetUniformLocation(program, "u_model");
+	auto projection_view_location = glGetUniformLocation(program, "u_projection_view");
+	auto surface_color_location = glGetUniformLocation(program, "u_surface_color");
+	auto mars_location = glGetUniformLocation(program, "u_mars");
+	auto morph_camera_location = glGetUniformLocation(program, "u_morph_camera");
+	auto morph_range_location = glGetUniformLocation(program, "u_morph_range");
+	std::vector<glm::vec3> cube_positions{
+			glm::vec3(0, 0, -10.01),
+			glm::vec3(0, 0, -10.01),
+			glm::vec3(-0.05, -0.05, -10.01),
+	};
+	auto mars_x_angle = glm::radians(0.f);
+	auto mars_y_angle = glm::radians(0.f);
+
+	auto rover_1_x_angle = glm::radians(50.f);
+	auto rover_1_y_angle = glm::radians(50.f);
+	auto rover_2_x_angle = glm::radians(0.f);
+	auto rover_2_y_angle = glm::radians(0.f);
+
+	auto eye_pos = glm::vec3(0, 0, -10.2);
+	float sensitivity = 1;
+	/* Loop until the user closes the window */
+	while (!glfwWindowShouldClose(window))
+	{
+		/* Render here */
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Calculate mouse position
+		auto mouse_position = Globals.mouse_position;
+		mouse_position /= glm::dvec2(Globals.screen_dimensions);
+		mouse_position.y = 1. - mouse_position.y;
+		mouse_position = mouse_position * 2. - 1.;
+
+		glUniform2fv(mouse_location, 1, glm::value_ptr(glm::vec2(mouse_position)));
+
+
+		
+		mouse_position *= sensitivity;
+		if (Globals.h) {
+			eye_pos.x -= 0.025;
+		}
+		else if (Globals.l) {
+			eye_pos.x += 0.025;
+		}
+		if (Globals.k) {
+			eye_pos.y += 0.025;
+		}
+		else if (Globals.j) {
+			eye_pos.y -= 0.025;
+		}
+		if (Globals.u) {
+			eye_pos.z -= 0.025;
+		}
+		else if (Globals.i) {
+			eye_pos.z += 0.025;
+		}
+		if (Globals.plus) {
+			sensitivity++;
+			std::cout << "sensitivity is now " << sensitivity << std::endl;
+		}
+		else if (Globals.minus) {
+			sensitivity--;
+			std::cout << "sensitivity is now " << sensitivity << std::endl;
+		}
+		auto view = glm::lookAt(
+			eye_pos,
+			glm::vec3(mouse_position, 0),
+			glm::vec3(0, 1, 0)
+		);
+		// Draw
+		auto projection = glm::perspective(glm::radians(45.f), 1.f, 0.000001f, 100.f);
+
+		glUniformMatrix4fv(projection_view_location, 1, GL_FALSE, glm::value_ptr(projection * view));
+		const auto draw_cube = [&](glm::vec3 position,int index,glm::mat4 &mars_trans)
+		{
+			cubeVAO.Bind();
+			glm::mat4 rover_transform(1.0);
+			rover_transform = glm::translate(rover_transform, position);
+			rover_transform = glm::scale(rover_transform,glm::vec3(0.01f));
+
+			if (index != 0) {
+				rover_transform =  mars_trans* rover_transform;
+			}
+
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(rover_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(1, 0, 0)));
+			glDrawElements(cubeVAO.primitive_type, cubeVAO.element_array_count, cubeVAO.index_type, NULL);
+
+
+			torusVAO.Bind();
+			glm::mat4 wheel_transform(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, 1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, 1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, -1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, -1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+		};
+
+
+		
+		auto mars_radius = 10.f;
+		auto mars = glm::vec3(1);
+
+
+		auto position = glm::vec3(0, 0, 0);
+		auto mars_transform = glm::mat4(1);
+
+		mars_transform = glm::scale(mars_transform,glm::vec3(mars_radius));
+		if (Globals.w) {
+			mars_x_angle += glm::radians(1.f);
+		}else if (Globals.s) {
+			mars_x_angle -= glm::radians(1.f);
+		}	
+		if (Globals.a) {
+			mars_y_angle -= glm::radians(1.f);
+		}else if (Globals.d) {
+			mars_y_angle += glm::radians(1.f);
+		}
+		
+		mars_transform=glm::rotate(mars_transform, glm::radians(mars_x_angle), glm::vec3(-1, 0, 0));
+		mars_transform = glm::rotate(mars_transform, glm::radians(mars_y_angle), glm::vec3(0, 1, 0));
+
+		glUniform3fv(surface_color_location, 1, glm::value_ptr(position * 0.5f + 0.5f));
+		glUniform3fv(mars_location, 1, glm::value_ptr(mars));
+		if (Globals.terrain) {
+			// The chunks are on the unit sphere, so the camera goes back through the mars transform
+			auto camera = glm::vec3(glm::inverse(mars_transform) * glm::vec4(eye_pos, 1));
+			SelectTerrainChunks(mars_terrain, camera, projection * view * mars_transform, glm::radians(45.f), float(Globals.screen_dimensions.y));
+
+			// Interleaved chunks aren't quantized, their position_transform is the identity
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(mars_transform));
+			glUniform3fv(morph_camera_location, 1, glm::value_ptr(camera));
+			for (const auto& chunk : mars_terrain.selection) {
+				chunk.vao->Bind();
+				glUniform2fv(morph_range_location, 1, glm::value_ptr(chunk.morph_range));
+				glDrawElements(chunk.vao->primitive_type, chunk.vao->element_array_count, chunk.vao->index_type, NULL);
+			}
+			glUniform2fv(morph_range_location, 1, glm::value_ptr(glm::vec2(0)));
+		}
+		else {
+			auto projected_mars_radius = ProjectedSphereRadius(glm::length(eye_pos), mars_radius, glm::radians(45.f), float(Globals.screen_dimensions.y));
+			const auto& mars_lod = SelectLOD(mars_lods, projected_mars_radius);
+			const auto& sphereVAO = mars_lod.vao;
+
+			sphereVAO.Bind();
+			auto mars_model = mars_transform * sphereVAO.position_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(mars_model));
+			if (Globals.cluster_culling && !mars_lod.meshlets.meshlets.empty()) {
+				// The meshlets are on the unit sphere like the terrain, before quantization
+				auto camera = glm::vec3(glm::inverse(mars_transform) * glm::vec4(eye_pos, 1));
+				CullMeshlets(mars_lod.meshlets, camera, ExtractFrustum(projection * view * mars_transform), mars_visible_indices.indices);
+
+				UploadStreamedIndices(mars_visible_indices);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mars_visible_indices.buffer);
+				glDrawElements(GL_TRIANGLES, GLsizei(mars_visible_indices.indices.size()), GL_UNSIGNED_INT, NULL);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereVAO.element_array_buffer);
+			}
+			else {
+				glDrawElements(sphereVAO.primitive_type, sphereVAO.element_array_count, sphereVAO.index_type, NULL);
+			}
+		}
+
+		mars = glm::vec3(0);
+
+		int index = 0;
+		for (const auto& position : cube_positions) {
+			glUniform3fv(mars_location, 1, glm::value_ptr(mars));
+			glm::mat4 mars_trans = mars_transform;
+			//draw_cube(p,index,mars_trans);
+			cubeVAO.Bind();
+			glm::mat4 rover_transform(1.0);
+			//chasing_pos = glm::mix(mouse_position, chasing_pos, 0.99);
+
+			if (index != 0) {
+				
+				if (index == 1) {
+					rover_transform = glm::rotate(rover_transform, glm::radians(rover_1_x_angle), glm::vec3(-1, 0, 0));
+					rover_transform = glm::rotate(rover_transform, glm::radians(rover_1_y_angle), glm::vec3(0, 1, 0));
+					auto distance_x = mars_x_angle - rover_1_x_angle;
+					if (distance_x == abs(distance_x)) {
+						rover_1_x_angle += 0.5;
+					}
+					else {
+						rover_1_x_angle -= 0.5;
+					}
+					auto distance_y = mars_y_angle - rover_1_y_angle;
+					if (distance_y == abs(distance_y)) {
+						rover_1_y_angle += 0.5;
+					}
+					else {
+						rover_1_y_angle -= 0.5;
+					}
+
+					std::cout << rover_1_x_angle << std::endl;
+					
+				}else if (index == 2) {
+					rover_transform = glm::rotate(rover_transform, glm::radians(mars_x_angle), glm::vec3(-1, 0, 0));
+					rover_transform = glm::rotate(rover_transform, glm::radians(mars_y_angle), glm::vec3(0, 1, 0));
+				}
+
+			}
+			rover_transform = glm::translate(rover_transform, position);
+			rover_transform = glm::scale(rover_transform, glm::vec3(0.01f));
+
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(rover_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(1, 0, 0)));
+			glDrawElements(cubeVAO.primitive_type, cubeVAO.element_array_count, cubeVAO.index_type, NULL);
+
+
+			torusVAO.Bind();
+			glm::mat4 wheel_transform(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, 1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, 1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(1.5, -1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+			wheel_transform = glm::mat4(1.0);
+			wheel_transform = glm::scale(wheel_transform, glm::vec3(0.25));
+			wheel_transform = glm::translate(wheel_transform, glm::vec3(-1.5, -1, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(90.f), glm::vec3(0, 0, 1));
+			wheel_transform = glm::rotate(wheel_transform, glm::radians(float(glfwGetTime()) * 100), glm::vec3(0, -1, 0));
+
+			wheel_transform = rover_transform * wheel_transform;
+			glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(wheel_transform));
+			glUniform3fv(surface_color_location, 1, glm::value_ptr(glm::vec3(0, 0, 1)));
+			glDrawElements(torusVAO.primitive_type, torusVAO.element_array_count, torusVAO.index_type, NULL);
+
+
+
+			index++;
+		}
+
+		/* Swap front and back buffers */
+		glfwSwapBuffers(window);
+
+		/* Poll for and process events */
+		glfwPollEvents();
+	}
+
+	ReleaseTerrain(mars_terrain);
+	ReleaseStreamedIndices(mars_visible_indices);
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,244 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mesh_cache.h"
+
+#include <cstdio>
+#include <cstring>
+
+static const char* mesh_cache_directory = "MeshCache";
+
+static std::string MeshCachePath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(key));
+	return std::string(mesh_cache_directory) + "/" + name;
+}
+
+/* Mesh Cache */
+uint64_t MeshCacheKey(const char* generator, std::initializer_list<uint32_t> revisions, std::initializer_list<double> parameters)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto Hash = [&hash](const void* data, size_t size)
+	{
+		auto bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	Hash(generator, strlen(generator) + 1);
+	for (auto revision : revisions)
+		Hash(&revision, sizeof(revision));
+	for (auto parameter : parameters)
+		Hash(&parameter, sizeof(parameter));
+	Hash(&mesh_cache_version, sizeof(mesh_cache_version));
+	return hash;
+}
+
+MappedMesh::~MappedMesh()
+{
+	Unmap();
+}
+
+bool MappedMesh::Map(const std::string& path)
+{
+	Unmap();
+
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		file = nullptr;
+		return false;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		Unmap();
+		return false;
+	}
+	size = size_t(file_size.QuadPart);
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping)
+	{
+		Unmap();
+		return false;
+	}
+	view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	auto descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return false;
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+	{
+		close(descriptor);
+		return false;
+	}
+	size = size_t(status.st_size);
+	auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	view = address == MAP_FAILED ? nullptr : address;
+#endif
+	if (!view)
+	{
+		Unmap();
+		return false;
+	}
+	return true;
+}
+
+void MappedMesh::Unmap()
+{
+#ifdef _WIN32
+	if (view)
+		UnmapViewOfFile(view);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+	file = mapping = nullptr;
+#else
+	if (view)
+		munmap(const_cast<void*>(view), size);
+#endif
+	view = nullptr;
+	size = 0;
+	positions = normals = nullptr;
+	uvs = nullptr;
+	indices = nullptr;
+	vertex_count = index_count = 0;
+	bounds = Bounds();
+	meshlets = nullptr;
+	meshlet_vertices = nullptr;
+	meshlet_triangles = nullptr;
+	meshlet_count = meshlet_vertex_count = meshlet_triangle_count = 0;
+}
+
+MeshletMesh CachedMeshlets(const MappedMesh& mesh)
+{
+	MeshletMesh meshlets;
+	meshlets.meshlets.assign(mesh.meshlets, mesh.meshlets + mesh.meshlet_count);
+	meshlets.vertices.assign(mesh.meshlet_vertices, mesh.meshlet_vertices + mesh.meshlet_vertex_count);
+	meshlets.triangles.assign(mesh.meshlet_triangles, mesh.meshlet_triangles + mesh.meshlet_triangle_count * 3);
+	return meshlets;
+}
+
+bool LoadMeshCache(uint64_t key, MappedMesh& mesh)
+{
+	if (!mesh.Map(MeshCachePath(key)))
+		return false;
+
+	auto bytes = static_cast<const char*>(mesh.view);
+	MeshCacheHeader header;
+	if (mesh.size < sizeof(header))
+	{
+		mesh.Unmap();
+		return false;
+	}
+	memcpy(&header, bytes, sizeof(header));
+
+	auto expected_size = sizeof(header)
+		+ header.vertex_count * (2 * sizeof(glm::vec3) + sizeof(glm::vec2))
+		+ header.index_count * sizeof(GLuint)
+		+ header.meshlet_count * sizeof(Meshlet)
+		+ header.meshlet_vertex_count * sizeof(GLuint)
+		+ header.meshlet_triangle_count * 3 * sizeof(uint8_t);
+	if (memcmp(header.magic, "MESH", 4) != 0 || header.version != mesh_cache_version || header.key != key || mesh.size != expected_size)
+	{
+		mesh.Unmap();
+		return false;
+	}
+
+	// Every array starts at a multiple of 4 bytes, so does the header's length
+	auto data = bytes + sizeof(header);
+	mesh.vertex_count = size_t(header.vertex_count);
+	mesh.index_count = size_t(header.index_count);
+	mesh.bounds = header.bounds;
+	mesh.positions = reinterpret_cast<const glm::vec3*>(data);
+	mesh.normals = mesh.positions + mesh.vertex_count;
+	mesh.uvs = reinterpret_cast<const glm::vec2*>(mesh.normals + mesh.vertex_count);
+	mesh.indices = reinterpret_cast<const GLuint*>(mesh.uvs + mesh.vertex_count);
+
+	// The byte sized triangles come last, they would break the alignment of anything after them
+	mesh.meshlet_count = size_t(header.meshlet_count);
+	mesh.meshlet_vertex_count = size_t(header.meshlet_vertex_count);
+	mesh.meshlet_triangle_count = size_t(header.meshlet_triangle_count);
+	mesh.meshlets = reinterpret_cast<const Meshlet*>(mesh.indices + mesh.index_count);
+	mesh.meshlet_vertices = reinterpret_cast<const GLuint*>(mesh.meshlets + mesh.meshlet_count);
+	mesh.meshlet_triangles = reinterpret_cast<const uint8_t*>(mesh.meshlet_vertices + mesh.meshlet_vertex_count);
+	return true;
+}
+
+bool SaveMeshCache(
+	uint64_t key,
+	const std::vector<glm::vec3>& positions,
+	const std::vector<glm::vec3>& normals,
+	const std::vector<glm::vec2>& uvs,
+	const std::vector<GLuint>& indices,
+	const Bounds& bounds,
+	const MeshletMesh& meshlets
+)
+{
+	if (normals.size() != positions.size() || uvs.size() != positions.size())
+		return false;
+
+#ifdef _WIN32
+	_mkdir(mesh_cache_directory);
+#else
+	mkdir(mesh_cache_directory, 0755);
+#endif
+
+	// Written under a temporary name and renamed, so an interrupted write never leaves a valid looking entry
+	auto path = MeshCachePath(key);
+	auto temporary_path = path + ".tmp";
+	auto file = fopen(temporary_path.c_str(), "wb");
+	if (!file)
+		return false;
+
+	MeshCacheHeader header;
+	memcpy(header.magic, "MESH", 4);
+	header.version = mesh_cache_version;
+	header.key = key;
+	header.vertex_count = positions.size();
+	header.index_count = indices.size();
+	header.meshlet_count = meshlets.meshlets.size();
+	header.meshlet_vertex_count = meshlets.vertices.size();
+	header.meshlet_triangle_count = meshlets.TriangleCount();
+	header.bounds = bounds;
+
+	auto written = fwrite(&header, sizeof(header), 1, file) == 1;
+	written = written && fwrite(positions.data(), sizeof(glm::vec3), positions.size(), file) == positions.size();
+	written = written && fwrite(normals.data(), sizeof(glm::vec3), normals.size(), file) == normals.size();
+	written = written && fwrite(uvs.data(), sizeof(glm::vec2), uvs.size(), file) == uvs.size();
+	written = written && fwrite(indices.data(), sizeof(GLuint), indices.size(), file) == indices.size();
+	written = written && fwrite(meshlets.meshlets.data(), sizeof(Meshlet), meshlets.meshlets.size(), file) == meshlets.meshlets.size();
+	written = written && fwrite(meshlets.vertices.data(), sizeof(GLuint), meshlets.vertices.size(), file) == meshlets.vertices.size();
+	written = written && fwrite(meshlets.triangles.data(), sizeof(uint8_t), meshlets.triangles.size(), file) == meshlets.triangles.size();
+	written = fclose(file) == 0 && written;
+
+	// Replacing the old entry in the same step, a crash leaves either of them in place
+#ifdef _WIN32
+	auto renamed = written && MoveFileExA(temporary_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	auto renamed = written && rename(temporary_path.c_str(), path.c_str()) == 0;
+#endif
+	if (!renamed)
+	{
+		remove(temporary_path.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "bounds.h"
+#include "meshlets.h"
+
+/*
+	Generated meshes are stored as MeshCache/<key>.mesh: a MeshCacheHeader, with the bounds the generator
+	returned, followed by the positions, normals, uvs and indices, then the meshlets, their vertices and their
+	triangles, each as a tightly packed array. Loading maps the file, so the arrays go to glBufferData
+	(or VAO's pointer constructor) without being copied or parsed. Nothing here needs a GL context, CachedVAO in
+	opengl_utilities.h builds VAOs from the entries.
+*/
+
+/* Mesh Cache */
+// Bump whenever the file layout changes, every existing entry then counts as stale
+constexpr uint32_t mesh_cache_version = 3;
+
+// FNV-1a over the generator name, the revisions of every step that shapes the stored mesh, like generator_revision
+// and mesh_utilities_revision, its parameters and mesh_cache_version. A changed step gets new keys, so its stale
+// entries are never loaded.
+uint64_t MeshCacheKey(const char* generator, std::initializer_list<uint32_t> revisions, std::initializer_list<double> parameters);
+
+struct MeshCacheHeader
+{
+	char magic[4];	// "MESH"
+	uint32_t version;
+	uint64_t key;
+	uint64_t vertex_count;
+	uint64_t index_count;
+	uint64_t meshlet_count;
+	uint64_t meshlet_vertex_count;
+	uint64_t meshlet_triangle_count;
+	Bounds bounds;
+};
+static_assert(sizeof(MeshCacheHeader) % 8 == 0, "the arrays after the header have to stay aligned");
+
+// A read-only view of a cache file, valid until the object is destroyed
+class MappedMesh
+{
+public:
+	MappedMesh() = default;
+	MappedMesh(const MappedMesh&) = delete;
+	MappedMesh& operator=(const MappedMesh&) = delete;
+	~MappedMesh();
+
+	const glm::vec3* positions = nullptr;
+	const glm::vec3* normals = nullptr;
+	const glm::vec2* uvs = nullptr;
+	const GLuint* indices = nullptr;
+	size_t vertex_count = 0;
+	size_t index_count = 0;
+	Bounds bounds;
+
+	// Empty when the entry was written without them
+	const Meshlet* meshlets = nullptr;
+	const GLuint* meshlet_vertices = nullptr;
+	const uint8_t* meshlet_triangles = nullptr;	// Three per triangle
+	size_t meshlet_count = 0;
+	size_t meshlet_vertex_count = 0;
+	size_t meshlet_triangle_count = 0;
+
+	bool Map(const std::string& path);
+	void Unmap();
+
+private:
+	friend bool LoadMeshCache(uint64_t key, MappedMesh& mesh);
+
+	const void* view = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// False when the entry is missing, from another version or key, or truncated. The caller regenerates it then.
+bool LoadMeshCache(uint64_t key, MappedMesh& mesh);
+
+bool SaveMeshCache(
+	uint64_t key,
+	const std::vector<glm::vec3>& positions,
+	const std::vector<glm::vec3>& normals,
+	const std::vector<glm::vec2>& uvs,
+	const std::vector<GLuint>& indices,
+	const Bounds& bounds,
+	const MeshletMesh& meshlets = MeshletMesh()
+);
+
+// Copies the meshlets out of a mapped entry
+MeshletMesh CachedMeshlets(const MappedMesh& mesh);
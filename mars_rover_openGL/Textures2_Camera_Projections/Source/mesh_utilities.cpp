@@ -0,0 +1,717 @@
+#include "mesh_utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <numeric>
+#include <unordered_map>
+
+#include "generators.h"
+
+/* Vertex Cache */
+VertexCacheStats AnalyzeVertexCache(
+	const std::vector<GLuint>& indices,
+	GLenum primitive_type,
+	int cache_size,
+	CacheModel cache_model
+)
+{
+	std::deque<GLuint> cache;
+	std::vector<GLuint> referenced;
+	size_t misses = 0;
+	size_t triangles = 0;
+	size_t strip_length = 0;
+
+	for (auto index : indices)
+	{
+		if (primitive_type == GL_TRIANGLE_STRIP)
+		{
+			if (index == primitive_restart_index)
+			{
+				strip_length = 0;
+				continue;
+			}
+			if (++strip_length >= 3)
+				++triangles;
+		}
+
+		auto cached = std::find(cache.begin(), cache.end(), index);
+		if (cached == cache.end())
+		{
+			++misses;
+			referenced.push_back(index);
+			cache.push_front(index);
+			if (int(cache.size()) > cache_size)
+				cache.pop_back();
+		}
+		else if (cache_model == CacheModel::LRU)
+		{
+			cache.erase(cached);
+			cache.push_front(index);
+		}
+	}
+	if (primitive_type != GL_TRIANGLE_STRIP)
+		triangles = indices.size() / 3;
+
+	std::sort(referenced.begin(), referenced.end());
+	auto unique_vertices = size_t(std::unique(referenced.begin(), referenced.end()) - referenced.begin());
+
+	VertexCacheStats stats;
+	stats.acmr = triangles ? misses / double(triangles) : 0;
+	stats.atvr = unique_vertices ? misses / double(unique_vertices) : 0;
+	return stats;
+}
+
+void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, int cache_size)
+{
+	auto triangle_count = indices.size() / 3;
+
+	// Vertex to triangle adjacency, the triangles of vertex v are adjacency[offsets[v]] up to adjacency[offsets[v + 1]]
+	std::vector<int> live(vertex_count, 0);
+	for (auto index : indices)
+		++live[index];
+	std::vector<size_t> offsets(vertex_count + 1, 0);
+	for (size_t v = 0; v < vertex_count; ++v)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<size_t> adjacency(indices.size());
+	{
+		auto fill = offsets;
+		for (size_t i = 0; i < indices.size(); ++i)
+			adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<int> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<GLuint> dead_end;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+
+	auto time = cache_size + 1;
+	size_t cursor = 0;
+	auto fanning = vertex_count ? 0 : -1;
+
+	// Nothing in the neighbourhood is live, fall back to recently used vertices and then to input order
+	auto SkipDeadEnd = [&]()
+	{
+		while (!dead_end.empty())
+		{
+			auto v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0)
+				return int(v);
+		}
+		for (; cursor < vertex_count; ++cursor)
+			if (live[cursor] > 0)
+				return int(cursor);
+		return -1;
+	};
+
+	// The candidate that is still in the cache after its remaining triangles are emitted and entered it first
+	auto NextVertex = [&]()
+	{
+		auto best = -1;
+		auto best_priority = -1;
+		for (auto v : candidates)
+		{
+			if (live[v] <= 0)
+				continue;
+			auto priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size)
+				priority = time - cache_time[v];
+			if (priority > best_priority)
+			{
+				best = int(v);
+				best_priority = priority;
+			}
+		}
+		return best != -1 ? best : SkipDeadEnd();
+	};
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (auto i = offsets[fanning]; i < offsets[fanning + 1]; ++i)
+		{
+			auto triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				auto v = indices[triangle * 3 + corner];
+				output.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cache_time[v] > cache_size)
+					cache_time[v] = time++;
+			}
+		}
+		fanning = NextVertex();
+	}
+
+	indices.swap(output);
+}
+
+/* Welding */
+WeldStats WeldVertices(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const WeldOptions& options
+)
+{
+	WeldStats stats;
+	stats.vertices_before = positions.size();
+	stats.triangles_before = indices.size() / 3;
+
+	auto has_uvs = uvs.size() == positions.size();
+	auto Matches = [&](GLuint a, GLuint b)
+	{
+		auto delta_position = glm::abs(positions[a] - positions[b]);
+		if (glm::max(glm::max(delta_position.x, delta_position.y), delta_position.z) > options.position_tolerance)
+			return false;
+		auto delta_normal = glm::abs(normals[a] - normals[b]);
+		if (glm::max(glm::max(delta_normal.x, delta_normal.y), delta_normal.z) > options.attribute_tolerance)
+			return false;
+		if (has_uvs && !options.ignore_uvs)
+		{
+			auto delta_uv = glm::abs(uvs[a] - uvs[b]);
+			if (glm::max(delta_uv.x, delta_uv.y) > options.attribute_tolerance)
+				return false;
+		}
+		return true;
+	};
+
+	// Cells are as large as the tolerance, so a match is at most one cell away on every axis.
+	// Each cell keeps the last vertex inserted into it, earlier ones are chained through next_in_cell.
+	auto Cell = [&options](const glm::vec3& position)
+	{
+		return glm::ivec3(glm::floor(position / options.position_tolerance));
+	};
+	auto CellKey = [](const glm::ivec3& cell)
+	{
+		return (uint64_t(uint32_t(cell.x)) * 73856093u) ^ (uint64_t(uint32_t(cell.y)) * 19349663u) ^ (uint64_t(uint32_t(cell.z)) * 83492791u);
+	};
+	const GLuint none = 0xFFFFFFFF;
+	std::unordered_map<uint64_t, GLuint> cells;
+	cells.reserve(positions.size());
+	std::vector<GLuint> next_in_cell(positions.size(), none);
+	std::vector<GLuint> remap(positions.size());
+
+	for (GLuint i = 0; i < GLuint(positions.size()); ++i)
+	{
+		auto cell = Cell(positions[i]);
+		remap[i] = i;
+		for (int z = -1; z <= 1 && remap[i] == i; ++z)
+			for (int y = -1; y <= 1 && remap[i] == i; ++y)
+				for (int x = -1; x <= 1 && remap[i] == i; ++x)
+				{
+					auto found = cells.find(CellKey(cell + glm::ivec3(x, y, z)));
+					if (found == cells.end())
+						continue;
+					// Hash collisions only cost extra comparisons, Matches checks the real positions
+					for (auto j = found->second; j != none; j = next_in_cell[j])
+						if (remap[j] == j && Matches(i, j))
+						{
+							remap[i] = j;
+							break;
+						}
+				}
+		if (remap[i] != i)
+			continue;
+
+		auto& head = cells.emplace(CellKey(cell), none).first->second;
+		next_in_cell[i] = head;
+		head = i;
+	}
+
+	// Drop triangles that collapsed onto an edge or a point. Vertices kept apart by their attributes can still
+	// coincide, so a triangle also goes when its height over the longest edge is below the tolerance.
+	std::vector<GLuint> welded;
+	welded.reserve(indices.size());
+	std::vector<bool> referenced(positions.size(), false);
+	for (size_t t = 0; t + 2 < indices.size(); t += 3)
+	{
+		GLuint a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+		if (a == b || b == c || c == a)
+			continue;
+		auto ab = positions[b] - positions[a], bc = positions[c] - positions[b], ca = positions[a] - positions[c];
+		auto longest_edge = std::sqrt(glm::max(glm::max(glm::dot(ab, ab), glm::dot(bc, bc)), glm::dot(ca, ca)));
+		if (glm::length(glm::cross(ab, -ca)) <= options.position_tolerance * longest_edge)
+			continue;
+		welded.push_back(a);
+		welded.push_back(b);
+		welded.push_back(c);
+		referenced[a] = referenced[b] = referenced[c] = true;
+	}
+
+	// Compact in the original vertex order
+	std::vector<GLuint> compacted(positions.size(), none);
+	size_t count = 0;
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		if (!referenced[i])
+			continue;
+		compacted[i] = GLuint(count);
+		positions[count] = positions[i];
+		normals[count] = normals[i];
+		if (has_uvs)
+			uvs[count] = uvs[i];
+		++count;
+	}
+	positions.resize(count);
+	normals.resize(count);
+	if (has_uvs)
+		uvs.resize(count);
+	for (auto& index : welded)
+		index = compacted[index];
+	indices.swap(welded);
+
+	stats.vertices_after = positions.size();
+	stats.triangles_after = indices.size() / 3;
+	return stats;
+}
+
+/* Simplification */
+namespace
+{
+	// Sum of weight * (dot(normal, p) + d)^2 over a set of planes as a symmetric 4x4 matrix, and the summed weight
+	struct Quadric
+	{
+		double a00, a11, a22, a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	enum class VertexKind : uint8_t
+	{
+		Manifold,	// Surrounded by triangles, one set of attributes
+		Border,		// On a single open border
+		Seam,		// One of the two sides of a single attribute seam
+		Locked		// Corners, where seams and borders meet or branch
+	};
+
+	Quadric PlaneQuadric(const glm::dvec3& normal, double d, double weight)
+	{
+		return Quadric{
+			normal.x * normal.x * weight, normal.y * normal.y * weight, normal.z * normal.z * weight,
+			normal.x * normal.y * weight, normal.x * normal.z * weight, normal.y * normal.z * weight,
+			normal.x * d * weight, normal.y * d * weight, normal.z * d * weight,
+			d * d * weight,
+			weight
+		};
+	}
+
+	void AddQuadric(Quadric& quadric, const Quadric& other)
+	{
+		quadric.a00 += other.a00;
+		quadric.a11 += other.a11;
+		quadric.a22 += other.a22;
+		quadric.a01 += other.a01;
+		quadric.a02 += other.a02;
+		quadric.a12 += other.a12;
+		quadric.b0 += other.b0;
+		quadric.b1 += other.b1;
+		quadric.b2 += other.b2;
+		quadric.c += other.c;
+		quadric.weight += other.weight;
+	}
+
+	// Weighted sum of the squared distances to the planes
+	double QuadricSum(const Quadric& quadric, const glm::dvec3& p)
+	{
+		auto x = quadric.a00 * p.x + quadric.a01 * p.y + quadric.a02 * p.z + 2 * quadric.b0;
+		auto y = quadric.a01 * p.x + quadric.a11 * p.y + quadric.a12 * p.z + 2 * quadric.b1;
+		auto z = quadric.a02 * p.x + quadric.a12 * p.y + quadric.a22 * p.z + 2 * quadric.b2;
+		return std::abs(p.x * x + p.y * y + p.z * z + quadric.c);
+	}
+
+	// Mean squared distance to the planes of both quadrics, without adding them up first
+	double QuadricError(const Quadric& quadric0, const Quadric& quadric1, const glm::dvec3& p)
+	{
+		auto weight = quadric0.weight + quadric1.weight;
+		return (QuadricSum(quadric0, p) + QuadricSum(quadric1, p)) / (weight > 0 ? weight : 1);
+	}
+}
+
+SimplifyStats SimplifyMesh(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const SimplifyOptions& options
+)
+{
+	const GLuint none = 0xFFFFFFFF, multiple = 0xFFFFFFFE;
+	const double edge_weight = 10;	// Keeps borders and seams in place against the planes of their triangles
+
+	SimplifyStats stats;
+	stats.vertices_before = positions.size();
+	stats.triangles_before = indices.size() / 3;
+	stats.error = 0;
+	stats.passes = 0;
+
+	auto vertex_count = positions.size();
+	auto has_uvs = uvs.size() == vertex_count;
+	indices.resize(indices.size() / 3 * 3);
+
+	// Vertices at exactly the same position share remap, the first of them. wedge links them into a ring.
+	std::vector<GLuint> remap(vertex_count), wedge(vertex_count);
+	{
+		std::vector<GLuint> order(vertex_count);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&positions](GLuint a, GLuint b)
+		{
+			const auto &p = positions[a], &q = positions[b];
+			return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+		});
+		for (size_t begin = 0, end; begin < vertex_count; begin = end)
+		{
+			for (end = begin + 1; end < vertex_count && positions[order[end]] == positions[order[begin]]; ++end);
+			for (auto i = begin; i < end; ++i)
+			{
+				remap[order[i]] = order[begin];
+				wedge[order[i]] = order[i + 1 < end ? i + 1 : begin];
+			}
+		}
+	}
+
+	// Triangles around every position, rebuilt for every pass
+	std::vector<GLuint> adjacency_offsets(vertex_count + 1), adjacency, adjacency_cursor;
+	auto BuildAdjacency = [&]()
+	{
+		std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+		for (auto index : indices)
+			++adjacency_offsets[remap[index] + 1];
+		for (size_t v = 0; v < vertex_count; ++v)
+			adjacency_offsets[v + 1] += adjacency_offsets[v];
+		adjacency.resize(indices.size());
+		adjacency_cursor.assign(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i)
+			adjacency[adjacency_cursor[remap[indices[i]]]++] = GLuint(i / 3);
+	};
+	auto HasEdge = [&](GLuint a, GLuint b)
+	{
+		auto r = remap[a];
+		for (auto i = adjacency_offsets[r]; i < adjacency_offsets[r + 1]; ++i)
+		{
+			const auto* triangle = &indices[adjacency[i] * 3];
+			for (int k = 0; k < 3; ++k)
+				if (triangle[k] == a && triangle[(k + 1) % 3] == b)
+					return true;
+		}
+		return false;
+	};
+
+	// An edge without its opposite edge between the same two vertices is open, a border or one side of a seam.
+	// open_out and open_in follow the open edges around a vertex, when it has just one of each.
+	BuildAdjacency();
+	std::vector<GLuint> open_out(vertex_count, none), open_in(vertex_count, none);
+	std::vector<char> open_edges(indices.size(), 0);
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		auto a = indices[i], b = indices[i - i % 3 + (i + 1) % 3];
+		if (HasEdge(b, a))
+			continue;
+		open_edges[i] = 1;
+		open_out[a] = open_out[a] == none ? b : multiple;
+		open_in[b] = open_in[b] == none ? a : multiple;
+	}
+
+	std::vector<VertexKind> kinds(vertex_count, VertexKind::Locked);
+	for (GLuint v = 0; v < GLuint(vertex_count); ++v)
+	{
+		if (wedge[v] == v)
+		{
+			if (open_out[v] == none && open_in[v] == none)
+				kinds[v] = VertexKind::Manifold;
+			else if (open_out[v] < multiple && open_in[v] < multiple && open_out[v] != v)
+				kinds[v] = VertexKind::Border;
+		}
+		else if (wedge[wedge[v]] == v)
+		{
+			// Both sides run along the same pair of neighbouring positions, in opposite directions
+			auto w = wedge[v];
+			if (open_out[v] < multiple && open_in[v] < multiple && open_out[w] < multiple && open_in[w] < multiple &&
+				remap[open_out[v]] == remap[open_in[w]] && remap[open_in[v]] == remap[open_out[w]])
+				kinds[v] = VertexKind::Seam;
+		}
+	}
+
+	// Triangle planes weighted by area, and planes through the open edges perpendicular to their triangles
+	std::vector<Quadric> quadrics(vertex_count, Quadric{});
+	for (size_t t = 0; t < indices.size(); t += 3)
+	{
+		glm::dvec3 p[3] = { positions[indices[t]], positions[indices[t + 1]], positions[indices[t + 2]] };
+		auto normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+		auto double_area = glm::length(normal);
+		if (double_area == 0)
+			continue;
+		normal /= double_area;
+
+		auto quadric = PlaneQuadric(normal, -glm::dot(normal, p[0]), double_area / 2);
+		for (int k = 0; k < 3; ++k)
+			AddQuadric(quadrics[remap[indices[t + k]]], quadric);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (!open_edges[t + k])
+				continue;
+			auto edge = p[(k + 1) % 3] - p[k];
+			auto edge_normal = glm::cross(edge, normal);
+			auto length = glm::length(edge_normal);
+			if (length == 0)
+				continue;
+			edge_normal /= length;
+			auto edge_quadric = PlaneQuadric(edge_normal, -glm::dot(edge_normal, p[k]), glm::dot(edge, edge) * edge_weight);
+			AddQuadric(quadrics[remap[indices[t + k]]], edge_quadric);
+			AddQuadric(quadrics[remap[indices[t + (k + 1) % 3]]], edge_quadric);
+		}
+	}
+	open_edges.clear();
+	open_edges.shrink_to_fit();
+
+	auto error_limit = double(options.target_error) * options.target_error;
+	double max_error = 0;
+	auto triangle_count = indices.size() / 3;
+
+	std::vector<GLuint> best_target(vertex_count), collapse_remap(vertex_count), candidates, ring0;
+	std::vector<float> best_error(vertex_count);
+	std::vector<char> pass_locked(vertex_count), dirty(vertex_count, 1);
+	std::vector<GLuint> bucket_offsets(2049), marks(vertex_count);
+	GLuint mark = 0;
+	auto ErrorBucket = [](float error)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &error, sizeof(bits));
+		return bits >> 20;
+	};
+
+	while (triangle_count > options.target_triangles)
+	{
+		if (stats.passes > 0)
+			BuildAdjacency();
+
+		// The cheapest collapse of every vertex. Border and seam vertices may only follow their edge loop.
+		// Only vertices next to the collapses of the last pass can have a different one.
+		for (GLuint v = 0; v < GLuint(vertex_count); ++v)
+			if (dirty[remap[v]])
+				best_target[v] = none;
+		auto Consider = [&](GLuint v0, GLuint v1)
+		{
+			auto r0 = remap[v0], r1 = remap[v1];
+			auto kind = kinds[v0];
+			if (r0 == r1 || kind == VertexKind::Locked)
+				return;
+			if (kind != VertexKind::Manifold && (kinds[v1] != kind || (open_out[v0] != v1 && open_in[v0] != v1)))
+				return;
+
+			auto error = float(QuadricError(quadrics[r0], quadrics[r1], glm::dvec3(positions[v1])));
+			if (best_target[v0] == none || error < best_error[v0])
+			{
+				best_target[v0] = v1;
+				best_error[v0] = error;
+			}
+		};
+		// Every edge inside the mesh shows up once in each direction, open edges only the one way
+		for (size_t t = 0; t < indices.size(); t += 3)
+			for (int k = 0; k < 3; ++k)
+			{
+				auto a = indices[t + k], b = indices[t + (k + 1) % 3];
+				if (dirty[remap[a]])
+					Consider(a, b);
+				if (open_in[b] == a && dirty[remap[b]])
+					Consider(b, a);
+			}
+
+		// Counting sort on the exponent and the top three bits of the mantissa, close enough to cheapest first.
+		// The bits of positive floats are in the same order as their values.
+		std::fill(bucket_offsets.begin(), bucket_offsets.end(), 0);
+		size_t candidate_count = 0;
+		for (GLuint v = 0; v < GLuint(vertex_count); ++v)
+			if (best_target[v] != none && best_error[v] <= error_limit)
+			{
+				++bucket_offsets[ErrorBucket(best_error[v]) + 1];
+				++candidate_count;
+			}
+		if (candidate_count == 0)
+			break;
+		for (size_t b = 1; b < bucket_offsets.size(); ++b)
+			bucket_offsets[b] += bucket_offsets[b - 1];
+		candidates.resize(candidate_count);
+		for (GLuint v = 0; v < GLuint(vertex_count); ++v)
+			if (best_target[v] != none && best_error[v] <= error_limit)
+				candidates[bucket_offsets[ErrorBucket(best_error[v])]++] = v;
+
+		// Cheapest first. A collapse locks every position around the one that goes away for the rest of the
+		// pass, so the checks below see the triangles as they will be. Most candidates end up locked, so past the
+		// error of the cheapest collapses that would take out half of the triangles the rest wait for the next
+		// pass, where they may turn out cheaper.
+		std::fill(pass_locked.begin(), pass_locked.end(), 0);
+		std::fill(marks.begin(), marks.end(), 0);
+		mark = 0;
+		std::iota(collapse_remap.begin(), collapse_remap.end(), 0);
+		auto removable = triangle_count - options.target_triangles;
+		auto pass_goal = glm::min(triangle_count / 4, candidates.size() - 1);
+		auto pass_error = best_error[candidates[pass_goal]];
+		size_t removed = 0, collapses = 0;
+		for (auto v0 : candidates)
+		{
+			if (best_error[v0] > pass_error && removed > pass_goal / 5)
+				break;
+			auto v1 = best_target[v0];
+			auto r0 = remap[v0], r1 = remap[v1];
+			if (pass_locked[r0] || pass_locked[r1])
+				continue;
+
+			// Triangles on the edge go away, the others get r1 instead of r0 and must not turn over
+			auto valid = true;
+			size_t shared = 0;
+			glm::vec3 p1 = positions[v1];
+			ring0.clear();
+			for (auto i = adjacency_offsets[r0]; i < adjacency_offsets[r0 + 1] && valid; ++i)
+			{
+				const auto* triangle = &indices[adjacency[i] * 3];
+				auto on_edge = false;
+				for (int k = 0; k < 3; ++k)
+				{
+					auto r = remap[triangle[k]];
+					if (r == r1)
+						on_edge = true;
+					if (r != r0)
+					{
+						valid = valid && !pass_locked[r];
+						ring0.push_back(r);
+					}
+				}
+				if (on_edge)
+				{
+					++shared;
+					continue;
+				}
+
+				glm::vec3 p[3] = { positions[triangle[0]], positions[triangle[1]], positions[triangle[2]] };
+				auto before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (int k = 0; k < 3; ++k)
+					if (remap[triangle[k]] == r0)
+						p[k] = p1;
+				auto after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				valid = valid && glm::dot(before, after) > 0;
+			}
+			if (!valid || shared == 0)
+				continue;
+
+			// Link condition, the only positions next to both ends are the ones across the triangles on the edge
+			mark += 2;
+			for (auto r : ring0)
+				marks[r] = mark;
+			size_t common = 0;
+			for (auto i = adjacency_offsets[r1]; i < adjacency_offsets[r1 + 1]; ++i)
+				for (int k = 0; k < 3; ++k)
+				{
+					auto r = remap[indices[adjacency[i] * 3 + k]];
+					if (r != r1 && marks[r] == mark)
+					{
+						++common;
+						marks[r] = mark + 1;
+					}
+				}
+			if (common != shared)
+				continue;
+
+			// The other side of a seam follows along the same edge
+			if (kinds[v0] == VertexKind::Seam)
+			{
+				auto s0 = wedge[v0];
+				auto s1 = open_out[v0] == v1 ? open_in[s0] : open_out[s0];
+				if (s1 >= multiple || remap[s1] != r1)
+					continue;
+				collapse_remap[s0] = s1;
+			}
+			collapse_remap[v0] = v1;
+			AddQuadric(quadrics[r1], quadrics[r0]);
+
+			pass_locked[r0] = pass_locked[r1] = 1;
+			for (auto r : ring0)
+				pass_locked[r] = 1;
+			max_error = glm::max(max_error, double(best_error[v0]));
+			removed += shared;
+			++collapses;
+			if (removed >= removable)
+				break;
+		}
+		if (collapses == 0)
+			break;
+
+		size_t kept = 0;
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			auto a = collapse_remap[indices[t]], b = collapse_remap[indices[t + 1]], c = collapse_remap[indices[t + 2]];
+			if (remap[a] == remap[b] || remap[b] == remap[c] || remap[c] == remap[a])
+				continue;
+			indices[kept * 3] = a;
+			indices[kept * 3 + 1] = b;
+			indices[kept * 3 + 2] = c;
+			++kept;
+		}
+		indices.resize(kept * 3);
+		triangle_count = kept;
+
+		// Gone, moved, lost a neighbour or next to a grown quadric
+		dirty.assign(pass_locked.begin(), pass_locked.end());
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			auto a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+			if (pass_locked[a] || pass_locked[b] || pass_locked[c])
+				dirty[a] = dirty[b] = dirty[c] = 1;
+		}
+
+		// Edge loops skip the collapsed vertices. A loop pointing at a vertex that collapsed onto its own start
+		// continues past it.
+		for (auto* loop : { &open_out, &open_in })
+			for (GLuint v = 0; v < GLuint(vertex_count); ++v)
+			{
+				auto l = (*loop)[v];
+				if (l >= multiple)
+					continue;
+				auto r = collapse_remap[l];
+				(*loop)[v] = r == v ? (*loop)[l] : r;
+			}
+		++stats.passes;
+	}
+
+	// Compact in the original vertex order
+	std::vector<GLuint> compacted(vertex_count, none);
+	size_t count = 0;
+	for (auto index : indices)
+		compacted[index] = 0;
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		if (compacted[i] == none)
+			continue;
+		compacted[i] = GLuint(count);
+		positions[count] = positions[i];
+		normals[count] = normals[i];
+		if (has_uvs)
+			uvs[count] = uvs[i];
+		++count;
+	}
+	positions.resize(count);
+	normals.resize(count);
+	if (has_uvs)
+		uvs.resize(count);
+	for (auto& index : indices)
+		index = compacted[index];
+
+	stats.vertices_after = positions.size();
+	stats.triangles_after = indices.size() / 3;
+	stats.error = float(std::sqrt(max_error));
+	return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+// Part of the mesh cache keys of meshes that went through WeldVertices, OptimizeVertexCache or SimplifyMesh,
+// bump it whenever one of them produces different output
+constexpr uint32_t mesh_utilities_revision = 1;
+
+/* Vertex Cache */
+enum class CacheModel
+{
+	FIFO,	// Hits don't refresh an entry, like most fixed-function post-transform caches
+	LRU		// Hits move the entry to the front
+};
+
+struct VertexCacheStats
+{
+	double acmr;	// Average cache miss ratio, transformed vertices per triangle. 0.5 is the optimum for a large grid, 3 the worst case
+	double atvr;	// Average transform to vertex ratio, transformed vertices per referenced vertex. 1 is the optimum
+};
+
+// Simulates a post-transform cache of cache_size entries over the index stream.
+// GL_TRIANGLE_STRIP indices may contain primitive_restart_index, which is skipped.
+VertexCacheStats AnalyzeVertexCache(
+	const std::vector<GLuint>& indices,
+	GLenum primitive_type,
+	int cache_size,
+	CacheModel cache_model
+);
+
+// Tipsify (Sander, Nehab and Barczak 2007), reorders the triangles of a GL_TRIANGLES index list so
+// consecutive triangles share vertices that are still in a cache of cache_size entries. Linear in the
+// triangle count, the vertices themselves are untouched.
+void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, int cache_size = 16);
+
+/* Welding */
+struct WeldOptions
+{
+	float position_tolerance = 1e-5f;	// Vertices closer than this on every axis are coincident
+	float attribute_tolerance = 1e-3f;	// Coincident vertices are merged when their normals and uvs agree within this
+	bool ignore_uvs = false;			// Also merge across uv discontinuities, like the rings at the poles of a sphere
+};
+
+struct WeldStats
+{
+	size_t vertices_before, vertices_after;
+	size_t triangles_before, triangles_after;
+};
+
+// Merges coincident GL_TRIANGLES vertices found through a spatial hash, drops triangles that end up with a
+// repeated index or zero area, and compacts the vertex arrays to the vertices that are still referenced.
+// uvs may be empty. Triangle order is kept, so run it before OptimizeVertexCache.
+WeldStats WeldVertices(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const WeldOptions& options = WeldOptions()
+);
+
+/* Simplification */
+struct SimplifyOptions
+{
+	size_t target_triangles = 0;	// Stops once no more than this many triangles are left
+	float target_error = 1e-3f;		// or before a collapse would move the surface further than this, in position units
+};
+
+struct SimplifyStats
+{
+	size_t vertices_before, vertices_after;
+	size_t triangles_before, triangles_after;
+	float error;	// Largest of the collapses, root mean square distance to the planes of the triangles they merged
+	int passes;
+};
+
+// Quadric error metric simplification (Garland and Heckbert 1997) of GL_TRIANGLES by half edge collapses, so the
+// vertices that are left keep their normals and uvs as they are. Each pass collapses the cheapest edges whose
+// neighbourhoods don't overlap. Coincident vertices with different attributes, the two sides of a uv seam, only
+// collapse along the seam and both at once. Open borders only collapse along the border. Vertices where seams
+// or borders meet never move. Collapses that would flip a triangle or pinch the mesh are skipped.
+// Run WeldVertices first, vertices only count as coincident at exactly the same position. uvs may be empty.
+// The vertex arrays are compacted like WeldVertices does.
+SimplifyStats SimplifyMesh(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	const SimplifyOptions& options = SimplifyOptions()
+);
@@ -0,0 +1,264 @@
+#include "meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/* Meshlets */
+MeshletMesh BuildMeshlets(
+	const glm::vec3* positions,
+	size_t vertex_count,
+	const GLuint* indices,
+	size_t index_count,
+	int max_vertices,
+	int max_triangles
+)
+{
+	const uint32_t none = std::numeric_limits<uint32_t>::max();
+	const uint8_t outside = 0xff;
+	max_vertices = glm::clamp(max_vertices, 3, 255);
+	max_triangles = glm::clamp(max_triangles, 1, 255);
+	auto triangle_count = index_count / 3;
+
+	// Zero normals for degenerate triangles, they don't count towards the cones
+	std::vector<glm::vec3> triangle_normals(triangle_count), triangle_centers(triangle_count);
+	for (size_t t = 0; t < triangle_count; ++t)
+	{
+		const auto& a = positions[indices[t * 3]];
+		const auto& b = positions[indices[t * 3 + 1]];
+		const auto& c = positions[indices[t * 3 + 2]];
+		auto normal = glm::cross(b - a, c - a);
+		auto length = glm::length(normal);
+		triangle_normals[t] = length > 0 ? normal / length : glm::vec3(0);
+		triangle_centers[t] = (a + b + c) / 3.f;
+	}
+
+	// Triangles around every vertex that aren't in a meshlet yet, live_counts[v] of them from adjacency_offsets[v] on
+	std::vector<uint32_t> adjacency_offsets(vertex_count + 1, 0), live_counts(vertex_count, 0), adjacency(index_count);
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+		++live_counts[indices[i]];
+	for (size_t v = 0; v < vertex_count; ++v)
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + live_counts[v];
+	std::fill(live_counts.begin(), live_counts.end(), 0);
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		auto v = indices[i];
+		adjacency[adjacency_offsets[v] + live_counts[v]++] = uint32_t(i / 3);
+	}
+
+	MeshletMesh mesh;
+	std::vector<uint8_t> local(vertex_count, outside);	// Slot in the current meshlet
+	std::vector<char> used(triangle_count, 0);
+	std::vector<uint32_t> meshlet_triangles;
+	std::vector<glm::vec3> meshlet_positions;
+	Meshlet meshlet{};
+	glm::vec3 center_sum(0), normal_sum(0);
+
+	auto NewVertices = [&](uint32_t t)
+	{
+		return int(local[indices[t * 3]] == outside) + int(local[indices[t * 3 + 1]] == outside) + int(local[indices[t * 3 + 2]] == outside);
+	};
+
+	auto Add = [&](uint32_t t)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			auto v = indices[t * 3 + k];
+			if (local[v] == outside)
+			{
+				local[v] = uint8_t(meshlet.vertex_count++);
+				mesh.vertices.push_back(v);
+			}
+			mesh.triangles.push_back(local[v]);
+
+			auto* live = &adjacency[adjacency_offsets[v]];
+			auto& live_count = live_counts[v];
+			for (uint32_t i = 0; i < live_count; ++i)
+				if (live[i] == t)
+				{
+					live[i] = live[--live_count];
+					break;
+				}
+		}
+		used[t] = 1;
+		++meshlet.triangle_count;
+		meshlet_triangles.push_back(t);
+		center_sum += triangle_centers[t];
+		normal_sum += triangle_normals[t];
+	};
+
+	auto Finish = [&]()
+	{
+		meshlet_positions.clear();
+		for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+			meshlet_positions.push_back(positions[mesh.vertices[meshlet.vertex_offset + i]]);
+		auto bounds = ComputeBounds(meshlet_positions.data(), meshlet_positions.size());
+		meshlet.center = bounds.center;
+		meshlet.radius = bounds.radius;
+
+		// The cone has to hold the normal farthest from the axis. Past a half turn it can't be culled.
+		meshlet.cone_axis = glm::vec3(0);
+		meshlet.cone_cutoff = 1;
+		auto length = glm::length(normal_sum);
+		if (length > 1e-6f)
+		{
+			meshlet.cone_axis = normal_sum / length;
+			auto min_dot = 1.f;
+			for (auto t : meshlet_triangles)
+				if (triangle_normals[t] != glm::vec3(0))
+					min_dot = glm::min(min_dot, glm::dot(triangle_normals[t], meshlet.cone_axis));
+			if (min_dot > 0)
+				meshlet.cone_cutoff = std::sqrt(1 - min_dot * min_dot);
+		}
+
+		for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+			local[mesh.vertices[meshlet.vertex_offset + i]] = outside;
+		mesh.meshlets.push_back(meshlet);
+
+		meshlet = Meshlet{};
+		meshlet.vertex_offset = uint32_t(mesh.vertices.size());
+		meshlet.triangle_offset = uint32_t(mesh.triangles.size());
+		meshlet_triangles.clear();
+		center_sum = normal_sum = glm::vec3(0);
+	};
+
+	size_t seed_cursor = 0;
+	while (true)
+	{
+		auto best = none;
+		if (meshlet.triangle_count > 0 && meshlet.triangle_count < uint32_t(max_triangles))
+		{
+			auto meshlet_center = center_sum / float(meshlet.triangle_count);
+			auto normal_length = glm::length(normal_sum);
+			auto meshlet_normal = normal_length > 0 ? normal_sum / normal_length : glm::vec3(0);
+
+			// Fewest new vertices first, then the closest, facing the same way as the meshlet
+			auto best_new = 4;
+			auto best_cost = std::numeric_limits<float>::max();
+			for (uint32_t i = 0; i < meshlet.vertex_count; ++i)
+			{
+				auto v = mesh.vertices[meshlet.vertex_offset + i];
+				const auto* live = &adjacency[adjacency_offsets[v]];
+				for (uint32_t j = 0; j < live_counts[v]; ++j)
+				{
+					auto t = live[j];
+					auto new_vertices = NewVertices(t);
+					if (new_vertices > best_new || meshlet.vertex_count + new_vertices > uint32_t(max_vertices))
+						continue;
+
+					auto cost = glm::distance(triangle_centers[t], meshlet_center) * (2 - glm::dot(triangle_normals[t], meshlet_normal));
+					if (new_vertices < best_new || cost < best_cost)
+					{
+						best = t;
+						best_new = new_vertices;
+						best_cost = cost;
+					}
+				}
+			}
+		}
+
+		if (best == none && meshlet.triangle_count > 0)
+		{
+			auto finished = mesh.vertices.begin() + meshlet.vertex_offset;
+			auto finished_count = meshlet.vertex_count;
+			Finish();
+
+			// The next meshlet starts beside the last one, from the triangle with the fewest live neighbours, which
+			// would be the first to be left over as a meshlet of its own
+			auto fewest = none;
+			for (uint32_t i = 0; i < finished_count; ++i)
+			{
+				auto v = finished[i];
+				const auto* live = &adjacency[adjacency_offsets[v]];
+				for (uint32_t j = 0; j < live_counts[v]; ++j)
+				{
+					auto t = live[j];
+					auto neighbours = live_counts[indices[t * 3]] + live_counts[indices[t * 3 + 1]] + live_counts[indices[t * 3 + 2]];
+					if (neighbours < fewest)
+					{
+						best = t;
+						fewest = neighbours;
+					}
+				}
+			}
+		}
+
+		// Nothing nearby, on to the next triangle in index order
+		if (best == none)
+		{
+			while (seed_cursor < triangle_count && used[seed_cursor])
+				++seed_cursor;
+			if (seed_cursor == triangle_count)
+				break;
+			best = uint32_t(seed_cursor);
+		}
+
+		if (meshlet.vertex_count + NewVertices(best) > uint32_t(max_vertices))
+			Finish();
+		Add(best);
+	}
+	if (meshlet.triangle_count > 0)
+		Finish();
+
+	return mesh;
+}
+
+/* Meshlet Culling */
+MeshletCullStats CullMeshlets(
+	const MeshletMesh& mesh,
+	const glm::vec3& camera,
+	const Frustum& frustum,
+	std::vector<GLuint>& indices
+)
+{
+	MeshletCullStats stats;
+	stats.meshlets = mesh.meshlets.size();
+	indices.clear();
+
+	for (const auto& meshlet : mesh.meshlets)
+	{
+		// Back facing when the whole bounding sphere is within the cone's mirror image behind the meshlet
+		auto view = meshlet.center - camera;
+		if (glm::dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(view) + meshlet.radius)
+		{
+			++stats.back_facing;
+			continue;
+		}
+		if (!SphereInFrustum(frustum, meshlet.center, meshlet.radius))
+		{
+			++stats.outside;
+			continue;
+		}
+
+		++stats.visible;
+		stats.triangles += meshlet.triangle_count;
+		const auto* vertices = &mesh.vertices[meshlet.vertex_offset];
+		const auto* triangles = &mesh.triangles[meshlet.triangle_offset];
+		for (uint32_t i = 0; i < meshlet.triangle_count * 3; ++i)
+			indices.push_back(vertices[triangles[i]]);
+	}
+	return stats;
+}
+
+void UploadStreamedIndices(StreamedIndices& streamed)
+{
+	if (streamed.buffer == 0)
+		glGenBuffers(1, &streamed.buffer);
+
+	// Through the copy target, binding the element target would change the bound VAO
+	auto count = streamed.indices.size();
+	if (count > streamed.capacity)
+		streamed.capacity = glm::max(count, streamed.capacity + streamed.capacity / 2);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, streamed.buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, streamed.capacity * sizeof(GLuint), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, count * sizeof(GLuint), streamed.indices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void ReleaseStreamedIndices(StreamedIndices& streamed)
+{
+	glDeleteBuffers(1, &streamed.buffer);
+	streamed.buffer = 0;
+	streamed.capacity = 0;
+	streamed.indices.clear();
+}
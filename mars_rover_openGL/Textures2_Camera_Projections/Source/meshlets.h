@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "bounds.h"
+
+/*
+	Meshlets split a GL_TRIANGLES mesh into clusters of up to 64 vertices and 124 triangles that are small and flat
+	enough to cull as a whole. Every meshlet has a bounding sphere for the frustum and a cone around its triangle
+	normals. When the camera is inside the cone's back side, every triangle of the meshlet faces away from it.
+	CullMeshlets runs every frame on the CPU and collects the triangles of the meshlets that pass into an index list
+	for StreamedIndices. A sphere shows less than half of itself, so more than half of its meshlets are dropped.
+*/
+
+/* Meshlets */
+struct Meshlet
+{
+	uint32_t vertex_offset;		// Into MeshletMesh::vertices
+	uint32_t triangle_offset;	// First of its local indices in MeshletMesh::triangles, three per triangle
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+
+	// In the space of the positions
+	glm::vec3 center;
+	float radius;
+	glm::vec3 cone_axis;		// Average of the triangle normals
+	float cone_cutoff;			// Sine of the cone's half angle, 1 when the meshlet can't be back facing as a whole
+};
+
+struct MeshletMesh
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<GLuint> vertices;	// Mesh vertices of every meshlet
+	std::vector<uint8_t> triangles;	// Indices into the meshlet's vertices
+
+	size_t TriangleCount() const { return triangles.size() / 3; }
+};
+
+// Grows one meshlet at a time from a seed triangle, always adding the adjacent triangle that needs the fewest new
+// vertices and is closest to the meshlet, its normal weighing in. A meshlet is done when no adjacent triangle
+// fits. Triangles are taken from GL_TRIANGLES indices, max_vertices and max_triangles are at most 255.
+MeshletMesh BuildMeshlets(
+	const glm::vec3* positions,
+	size_t vertex_count,
+	const GLuint* indices,
+	size_t index_count,
+	int max_vertices = 64,
+	int max_triangles = 124
+);
+
+/* Meshlet Culling */
+struct MeshletCullStats
+{
+	size_t meshlets = 0;
+	size_t visible = 0;
+	size_t back_facing = 0;
+	size_t outside = 0;			// Of the frustum
+	size_t triangles = 0;		// Of the visible meshlets
+};
+
+// Replaces indices with the triangles of the meshlets that may be visible from camera inside frustum, both in the
+// space of the positions
+MeshletCullStats CullMeshlets(
+	const MeshletMesh& mesh,
+	const glm::vec3& camera,
+	const Frustum& frustum,
+	std::vector<GLuint>& indices
+);
+
+// An element buffer refilled every frame, GL_UNSIGNED_INT. Bound while a VAO is, it replaces the VAO's own
+// element buffer, which has to be bound back after the draw.
+struct StreamedIndices
+{
+	GLuint buffer = 0;
+	size_t capacity = 0;		// Indices the buffer has room for
+	std::vector<GLuint> indices;
+};
+
+// Orphans the buffer and uploads indices, growing it when they don't fit
+void UploadStreamedIndices(StreamedIndices& streamed);
+
+void ReleaseStreamedIndices(StreamedIndices& streamed);
@@ -1,96 +1,389 @@
-#include "opengl_utilities.h"
-
-/* OpenGL Utility Structs */
-
-VAO::VAO(
-	const std::vector<glm::vec3>& positions,
-	const std::vector<glm::vec3>& normals,
-	const std::vector<glm::vec2>& uvs,
-	const std::vector<GLuint>& indices
-)
-{
-	glGenVertexArrays(1, &id);
-	glBindVertexArray(id);
-
-	vertex_count = GLsizei(positions.size());
-
-	glGenBuffers(1, &position_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, position_buffer);
-	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
-	glEnableVertexAttribArray(0);
-
-
-	glGenBuffers(1, &normals_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, normals_buffer);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
-	glEnableVertexAttribArray(1);
-
-
-	glGenBuffers(1, &uv_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
-	glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
-	glEnableVertexAttribArray(2);
-
-
-	element_array_count = GLsizei(indices.size());
-
-	glGenBuffers(1, &element_array_buffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-};
-
-/* OpenGL Utility Functions */
-GLuint CreateShaderFromSource(const GLenum& shader_type, const GLchar * source)
-{
-	GLuint shader = glCreateShader(shader_type);
-	glShaderSource(shader, 1, &source, NULL);
-	glCompileShader(shader);
-
-	int success;
-	char info_log[512];
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-	if (!success)
-	{
-		std::cout << "Error: Shader Compilation failed" << std::endl;
-		glGetShaderInfoLog(shader, 512, NULL, info_log);
-		std::cout << info_log << std::endl;
-
-		glDeleteShader(shader);
-		return NULL;
-	}
-
-	return shader;
-}
-
-GLuint CreateProgramFromSources(const GLchar * vertex_shader_source, const GLchar * fragment_shader_source)
-{
-	GLuint program = glCreateProgram();
-
-	GLuint vertex_shader = CreateShaderFromSource(GL_VERTEX_SHADER, vertex_shader_source);
-	GLuint fragment_shader = CreateShaderFromSource(GL_FRAGMENT_SHADER, fragment_shader_source);
-
-	glAttachShader(program, vertex_shader);
-	glAttachShader(program, fragment_shader);
-	glLinkProgram(program);
-
-	int success;
-	char info_log[512];
-	glGetProgramiv(program, GL_LINK_STATUS, &success);
-	if (!success)
-	{
-		std::cout << "Error: Program Linking failed" << std::endl;
-		glGetProgramInfoLog(program, 512, NULL, info_log);
-		std::cout << info_log << std::endl;
-
-		glDeleteProgram(program);
-		return NULL;
-	}
-
-	return program;
-}
\ No newline at end of file
+#include "opengl_utilities.h"
+
+#include <cstddef>
+#include <initializer_list>
+
+/* Vertex Packing */
+
+struct InterleavedVertex
+{
+	glm::vec3 position;
+	GLuint normal;
+	GLushort uv[2];
+};
+
+struct QuantizedVertex
+{
+	GLshort position[4];	// The fourth one only pads the normal to a 4 byte boundary
+	GLuint normal;
+	GLushort uv[2];
+};
+
+static GLuint PackNormal(const glm::vec3* normals, size_t i)
+{
+	// GL_INT_2_10_10_10_REV, x in the lowest bits, w unused
+	auto normal = normals ? glm::clamp(normals[i], -1.f, 1.f) : glm::vec3(0);
+	auto n = glm::ivec3(glm::round(normal * 511.f));
+	return (GLuint(n.x) & 0x3FF) | ((GLuint(n.y) & 0x3FF) << 10) | ((GLuint(n.z) & 0x3FF) << 20);
+}
+
+static void PackUV(const glm::vec2* uvs, size_t i, GLushort* out)
+{
+	auto uv = uvs ? glm::clamp(uvs[i], 0.f, 1.f) : glm::vec2(0);
+	out[0] = GLushort(glm::round(uv.x * 65535.f));
+	out[1] = GLushort(glm::round(uv.y * 65535.f));
+}
+
+// Packs into GL_ARRAY_BUFFER
+static void UploadInterleavedVertices(
+	const glm::vec3* positions,
+	const glm::vec3* normals,
+	const glm::vec2* uvs,
+	size_t vertex_count
+)
+{
+	std::vector<InterleavedVertex> vertices(vertex_count);
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		vertices[i].position = positions[i];
+		vertices[i].normal = PackNormal(normals, i);
+		PackUV(uvs, i, vertices[i].uv);
+	}
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(InterleavedVertex), vertices.data(), GL_STATIC_DRAW);
+
+	auto stride = GLsizei(sizeof(InterleavedVertex));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(offsetof(InterleavedVertex, position)));
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, reinterpret_cast<void *>(offsetof(InterleavedVertex, normal)));
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<void *>(offsetof(InterleavedVertex, uv)));
+}
+
+// Packs into GL_ARRAY_BUFFER, returns the transform that undoes the quantization
+static glm::mat4 UploadQuantizedVertices(
+	const glm::vec3* positions,
+	const glm::vec3* normals,
+	const glm::vec2* uvs,
+	size_t vertex_count,
+	const Bounds& bounds
+)
+{
+	// One scale for every axis keeps the dequantization a similarity transform
+	auto size = bounds.max - bounds.min;
+	auto center = bounds.Empty() ? glm::vec3(0) : bounds.center;
+	auto extent = bounds.Empty() ? 0.f : glm::max(glm::max(size.x, size.y), size.z) * 0.5f;
+	auto scale = extent > 0 ? extent : 1.f;
+
+	std::vector<QuantizedVertex> vertices(vertex_count);
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		auto q = glm::round(glm::clamp((positions[i] - center) / scale, -1.f, 1.f) * 32767.f);
+		vertices[i].position[0] = GLshort(q.x);
+		vertices[i].position[1] = GLshort(q.y);
+		vertices[i].position[2] = GLshort(q.z);
+		vertices[i].position[3] = 0;
+		vertices[i].normal = PackNormal(normals, i);
+		PackUV(uvs, i, vertices[i].uv);
+	}
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(QuantizedVertex), vertices.data(), GL_STATIC_DRAW);
+
+	auto stride = GLsizei(sizeof(QuantizedVertex));
+	glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, reinterpret_cast<void *>(offsetof(QuantizedVertex, position)));
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, reinterpret_cast<void *>(offsetof(QuantizedVertex, normal)));
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, reinterpret_cast<void *>(offsetof(QuantizedVertex, uv)));
+
+	return glm::scale(glm::translate(glm::mat4(1), center), glm::vec3(scale));
+}
+
+/* OpenGL Utility Structs */
+
+VAO::VAO(
+	const std::vector<glm::vec3>& positions,
+	const std::vector<glm::vec3>& normals,
+	const std::vector<glm::vec2>& uvs,
+	const std::vector<GLuint>& indices,
+	VertexFormat vertex_format,
+	GLenum primitive_type,
+	const Bounds& bounds
+) :
+	VAO(
+		positions.data(),
+		normals.size() == positions.size() ? normals.data() : nullptr,
+		uvs.size() == positions.size() ? uvs.data() : nullptr,
+		positions.size(),
+		indices.data(),
+		indices.size(),
+		vertex_format,
+		primitive_type,
+		bounds
+	)
+{
+}
+
+VAO::VAO(
+	const glm::vec3* positions,
+	const glm::vec3* normals,
+	const glm::vec2* uvs,
+	size_t vertex_count,
+	const GLuint* indices,
+	size_t index_count,
+	VertexFormat vertex_format,
+	GLenum primitive_type,
+	const Bounds& bounds
+) :
+	vertex_format(vertex_format),
+	vertex_buffer(0),
+	position_transform(1),
+	bounds(bounds.Empty() ? ComputeBounds(positions, vertex_count) : bounds),
+	primitive_type(primitive_type)
+{
+	glGenVertexArrays(1, &id);
+	glBindVertexArray(id);
+
+	this->vertex_count = GLsizei(vertex_count);
+
+	if (vertex_format != VertexFormat::Separate)
+	{
+		position_buffer = normals_buffer = uv_buffer = 0;
+
+		glGenBuffers(1, &vertex_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		if (vertex_format == VertexFormat::Interleaved)
+			UploadInterleavedVertices(positions, normals, uvs, vertex_count);
+		else
+			position_transform = UploadQuantizedVertices(positions, normals, uvs, vertex_count, this->bounds);
+
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+	}
+	else
+	{
+		glGenBuffers(1, &position_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, position_buffer);
+		glBufferData(GL_ARRAY_BUFFER, vertex_count * sizeof(glm::vec3), positions, GL_STATIC_DRAW);
+
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+		glEnableVertexAttribArray(0);
+
+
+		glGenBuffers(1, &normals_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, normals_buffer);
+		glBufferData(GL_ARRAY_BUFFER, normals ? vertex_count * sizeof(glm::vec3) : 0, normals, GL_STATIC_DRAW);
+
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+		glEnableVertexAttribArray(1);
+
+
+		glGenBuffers(1, &uv_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
+		glBufferData(GL_ARRAY_BUFFER, uvs ? vertex_count * sizeof(glm::vec2) : 0, uvs, GL_STATIC_DRAW);
+
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+		glEnableVertexAttribArray(2);
+	}
+
+	element_array_count = GLsizei(index_count);
+
+	glGenBuffers(1, &element_array_buffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
+	if (vertex_count <= 0xFFFF)
+	{
+		// Indices can't exceed the vertex count, so halve the index buffer. 0xFFFF stays free as the restart
+		// index Bind sets, and narrowing turns the GLuint restart index 0xFFFFFFFF into exactly that.
+		index_type = GL_UNSIGNED_SHORT;
+		std::vector<GLushort> short_indices(indices, indices + index_count);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, short_indices.size() * sizeof(GLushort), short_indices.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		index_type = GL_UNSIGNED_INT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+	}
+};
+
+static GLuint CreateWriteOnlyBuffer(size_t size)
+{
+	// GL_COPY_WRITE_BUFFER leaves the VAO's GL_ELEMENT_ARRAY_BUFFER binding alone
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+	// Immutable storage that can only be mapped for writing tells the driver up front how the buffer is filled
+	if (GLAD_GL_ARB_buffer_storage)
+		glBufferStorage(GL_COPY_WRITE_BUFFER, GLsizeiptr(size), nullptr, GL_MAP_WRITE_BIT);
+	else
+		glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(size), nullptr, GL_STATIC_DRAW);
+	return buffer;
+}
+
+VAO::VAO(size_t vertex_count, size_t index_count, GLenum primitive_type) :
+	vertex_format(VertexFormat::Separate),
+	vertex_buffer(0),
+	position_transform(1),
+	primitive_type(primitive_type)
+{
+	glGenVertexArrays(1, &id);
+	glBindVertexArray(id);
+
+	this->vertex_count = GLsizei(vertex_count);
+
+	position_buffer = CreateWriteOnlyBuffer(vertex_count * sizeof(glm::vec3));
+	glBindBuffer(GL_ARRAY_BUFFER, position_buffer);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+	glEnableVertexAttribArray(0);
+
+	normals_buffer = CreateWriteOnlyBuffer(vertex_count * sizeof(glm::vec3));
+	glBindBuffer(GL_ARRAY_BUFFER, normals_buffer);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+	glEnableVertexAttribArray(1);
+
+	uv_buffer = CreateWriteOnlyBuffer(vertex_count * sizeof(glm::vec2));
+	glBindBuffer(GL_ARRAY_BUFFER, uv_buffer);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+	glEnableVertexAttribArray(2);
+
+	// The generators write GLuint indices, so there is no narrowing to GLushort here
+	element_array_count = GLsizei(index_count);
+	index_type = GL_UNSIGNED_INT;
+	element_array_buffer = CreateWriteOnlyBuffer(index_count * sizeof(GLuint));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_array_buffer);
+}
+
+bool VAO::Map(MeshSink& sink)
+{
+	// Invalidating lets the driver hand out fresh memory instead of waiting for or preserving the old contents
+	auto MapBuffer = [](GLuint buffer, size_t size)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		return glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, GLsizeiptr(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	};
+
+	sink.positions = static_cast<glm::vec3*>(MapBuffer(position_buffer, vertex_count * sizeof(glm::vec3)));
+	sink.normals = static_cast<glm::vec3*>(MapBuffer(normals_buffer, vertex_count * sizeof(glm::vec3)));
+	sink.uvs = static_cast<glm::vec2*>(MapBuffer(uv_buffer, vertex_count * sizeof(glm::vec2)));
+	sink.indices = static_cast<GLuint*>(MapBuffer(element_array_buffer, element_array_count * sizeof(GLuint)));
+	if (sink.positions && sink.normals && sink.uvs && sink.indices)
+		return true;
+
+	const GLuint buffers[] = { position_buffer, normals_buffer, uv_buffer, element_array_buffer };
+	const void* mapped[] = { sink.positions, sink.normals, sink.uvs, sink.indices };
+	for (int i = 0; i < 4; ++i)
+		if (mapped[i])
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+	return false;
+}
+
+bool VAO::Unmap()
+{
+	auto intact = true;
+	for (auto buffer : { position_buffer, normals_buffer, uv_buffer, element_array_buffer })
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		intact = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE && intact;
+	}
+	return intact;
+}
+
+size_t VAO::ByteSize() const
+{
+	size_t vertex_size = sizeof(glm::vec3) * 2 + sizeof(glm::vec2);
+	if (vertex_format == VertexFormat::Interleaved)
+		vertex_size = sizeof(InterleavedVertex);
+	else if (vertex_format == VertexFormat::InterleavedQuantized)
+		vertex_size = sizeof(QuantizedVertex);
+	auto index_size = index_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	return size_t(vertex_count) * vertex_size + size_t(element_array_count) * index_size;
+}
+
+void VAO::Bind() const
+{
+	glBindVertexArray(id);
+	glPrimitiveRestartIndex(index_type == GL_UNSIGNED_SHORT ? 0xFFFF : primitive_restart_index);
+}
+
+void VAO::Release()
+{
+	// Unused names are 0, which glDeleteBuffers skips
+	const GLuint buffers[] = { position_buffer, normals_buffer, uv_buffer, vertex_buffer, element_array_buffer };
+	glDeleteBuffers(GLsizei(sizeof(buffers) / sizeof(buffers[0])), buffers);
+	glDeleteVertexArrays(1, &id);
+	id = position_buffer = normals_buffer = uv_buffer = vertex_buffer = element_array_buffer = 0;
+	vertex_count = element_array_count = 0;
+}
+
+/* OpenGL Utility Functions */
+GLuint CreateShaderFromSource(const GLenum& shader_type, const GLchar * source)
+{
+	GLuint shader = glCreateShader(shader_type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	int success;
+	char info_log[512];
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		std::cout << "Error: Shader Compilation failed" << std::endl;
+		glGetShaderInfoLog(shader, 512, NULL, info_log);
+		std::cout << info_log << std::endl;
+
+		glDeleteShader(shader);
+		return NULL;
+	}
+
+	return shader;
+}
+
+GLuint CreateProgramFromSources(const GLchar * vertex_shader_source, const GLchar * fragment_shader_source)
+{
+	GLuint program = glCreateProgram();
+
+	GLuint vertex_shader = CreateShaderFromSource(GL_VERTEX_SHADER, vertex_shader_source);
+	GLuint fragment_shader = CreateShaderFromSource(GL_FRAGMENT_SHADER, fragment_shader_source);
+
+	glAttachShader(program, vertex_shader);
+	glAttachShader(program, fragment_shader);
+	glLinkProgram(program);
+
+	int success;
+	char info_log[512];
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		std::cout << "Error: Program Linking failed" << std::endl;
+		glGetProgramInfoLog(program, 512, NULL, info_log);
+		std::cout << info_log << std::endl;
+
+		glDeleteProgram(program);
+		return NULL;
+	}
+
+	return program;
+}
+
+GLuint CreateComputeProgramFromSource(const GLchar * compute_shader_source)
+{
+	GLuint program = glCreateProgram();
+
+	GLuint compute_shader = CreateShaderFromSource(GL_COMPUTE_SHADER, compute_shader_source);
+
+	glAttachShader(program, compute_shader);
+	glLinkProgram(program);
+
+	int success;
+	char info_log[512];
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		std::cout << "Error: Program Linking failed" << std::endl;
+		glGetProgramInfoLog(program, 512, NULL, info_log);
+		std::cout << info_log << std::endl;
+
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
@@ -1,36 +1,161 @@
-#pragma once
-
-#include <iostream>
-#include <vector>
-
-#include "GLAD/glad.h"
-#include "GLM/glm.hpp"
-
-/* OpenGL Utility Structs */
-
-struct VAO
-{
-	GLuint id;
-
-	GLsizei vertex_count;
-	GLuint position_buffer;
-	GLuint normals_buffer;
-	GLuint uv_buffer;
-
-	GLsizei element_array_count;
-	GLuint element_array_buffer;
-
-	VAO(
-		const std::vector<glm::vec3>& positions,
-		const std::vector<glm::vec3>& normals,
-		const std::vector<glm::vec2>& uvs,
-		const std::vector<GLuint>& indices
-	);
-};
-
-/* OpenGL Utility Functions */
-
-GLuint CreateShaderFromSource(const GLenum& shader_type, const GLchar * source);
-
-GLuint CreateProgramFromSources(const GLchar * vertex_shader_source, const GLchar * fragment_shader_source);
-
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "GLAD/glad.h"
+#include "GLM/glm.hpp"
+#include "GLM/gtc/matrix_transform.hpp"
+
+#include "bounds.h"
+#include "generators.h"
+#include "mesh_cache.h"
+#include "meshlets.h"
+
+/* OpenGL Utility Structs */
+
+enum class VertexFormat
+{
+	Separate,				// One float buffer per attribute, 32 bytes per vertex
+	Interleaved,			// float3 position, 2_10_10_10 normal, unorm16 uv in one buffer, 20 bytes per vertex
+	InterleavedQuantized	// Same, but with snorm16 positions relative to the mesh bounds, 16 bytes per vertex
+};
+
+struct VAO
+{
+	GLuint id;
+
+	GLsizei vertex_count;
+	GLuint position_buffer;
+	GLuint normals_buffer;
+	GLuint uv_buffer;
+
+	// Interleaved formats keep every attribute in vertex_buffer instead of the three buffers above
+	VertexFormat vertex_format;
+	GLuint vertex_buffer;
+
+	// Maps the stored positions back to the original ones, identity unless the positions are quantized.
+	// Multiply the model matrix with it. It only translates and scales uniformly, so normals are unaffected.
+	glm::mat4 position_transform;
+
+	// Of the original positions, before quantization. TransformBounds it with the model matrix for culling.
+	Bounds bounds;
+
+	GLsizei element_array_count;
+	GLuint element_array_buffer;
+	GLenum index_type;	// GL_UNSIGNED_SHORT when every index fits, GL_UNSIGNED_INT otherwise
+	GLenum primitive_type;	// Mode for glDrawElements
+
+	// normals or uvs that don't have one per position are left out, zero in the shader.
+	// bounds are the ones the generator returned along with the mesh, computed from the positions when empty.
+	VAO(
+		const std::vector<glm::vec3>& positions,
+		const std::vector<glm::vec3>& normals,
+		const std::vector<glm::vec2>& uvs,
+		const std::vector<GLuint>& indices,
+		VertexFormat vertex_format = VertexFormat::Separate,
+		GLenum primitive_type = GL_TRIANGLES,
+		const Bounds& bounds = Bounds()
+	);
+
+	// Same from raw arrays, like a mapped mesh cache file. normals and uvs may be null.
+	VAO(
+		const glm::vec3* positions,
+		const glm::vec3* normals,
+		const glm::vec2* uvs,
+		size_t vertex_count,
+		const GLuint* indices,
+		size_t index_count,
+		VertexFormat vertex_format = VertexFormat::Separate,
+		GLenum primitive_type = GL_TRIANGLES,
+		const Bounds& bounds = Bounds()
+	);
+
+	// Separate float buffers and GLuint indices with uninitialized storage, written through Map instead of
+	// being copied from CPU arrays, see MappedVAO below, or by a compute shader, see gpu_generators.h.
+	VAO(size_t vertex_count, size_t index_count, GLenum primitive_type = GL_TRIANGLES);
+
+	// Maps every buffer of a VAO from the constructor above write-only, nothing may be read through the sink.
+	// False if any mapping failed, none of them stay mapped then.
+	bool Map(MeshSink& sink);
+	// False if the driver lost the contents while they were mapped, they have to be written again then
+	bool Unmap();
+
+	// Binds the vertex array for drawing, and points the restart index of GL_PRIMITIVE_RESTART at the largest value
+	// of index_type, where primitive_restart_index ends up. No vertex has that index, so it is safe for every VAO.
+	void Bind() const;
+
+	// GPU memory of the vertex and index buffers
+	size_t ByteSize() const;
+
+	// Copies of a VAO share its objects, so nothing deletes them on its own. Deletes the vertex array and every
+	// buffer and leaves an empty VAO behind, for VAOs that come and go like terrain chunks.
+	void Release();
+};
+
+// Builds a VAO by calling generate(const MeshSink&) on its mapped buffers, generate returns the mesh bounds.
+// The mesh only ever exists in the buffers, there is no CPU copy to upload or keep around.
+template <typename Generate>
+VAO MappedVAO(size_t vertex_count, size_t index_count, const Generate& generate, GLenum primitive_type = GL_TRIANGLES)
+{
+	VAO vao(vertex_count, index_count, primitive_type);
+	for (int attempt = 0; attempt < 3; ++attempt)
+	{
+		MeshSink sink;
+		if (!vao.Map(sink))
+			break;
+		vao.bounds = generate(static_cast<const MeshSink&>(sink));
+		if (vao.Unmap())
+			return vao;
+	}
+	std::cout << "Error: the buffers of a mapped VAO couldn't be written" << std::endl;
+	return vao;
+}
+
+// Builds the VAO straight from the mapped cache entry. On a miss, calls generate(positions, normals, uvs, indices),
+// which returns the bounds of the positions, and stores its result first.
+// With meshlets, also fills them in, split from the GL_TRIANGLES the generator returned and stored in the same
+// entry, so they don't depend on the entry being written.
+template <typename Generate>
+VAO CachedVAO(
+	uint64_t key,
+	const Generate& generate,
+	VertexFormat vertex_format = VertexFormat::Separate,
+	GLenum primitive_type = GL_TRIANGLES,
+	MeshletMesh* meshlets = nullptr
+)
+{
+	MappedMesh cached;
+	if (LoadMeshCache(key, cached))
+	{
+		if (meshlets)
+			*meshlets = cached.meshlet_count > 0 || cached.index_count == 0
+				? CachedMeshlets(cached)
+				: BuildMeshlets(cached.positions, cached.vertex_count, cached.indices, cached.index_count);
+		return VAO(cached.positions, cached.normals, cached.uvs, cached.vertex_count, cached.indices, cached.index_count, vertex_format, primitive_type, cached.bounds);
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<GLuint> indices;
+	Bounds bounds = generate(positions, normals, uvs, indices);
+
+	MeshletMesh generated_meshlets;
+	if (meshlets)
+		generated_meshlets = BuildMeshlets(positions.data(), positions.size(), indices.data(), indices.size());
+	if (!SaveMeshCache(key, positions, normals, uvs, indices, bounds, generated_meshlets))
+		std::cout << "Mesh cache entry " << std::hex << key << std::dec << " couldn't be written" << std::endl;
+	if (meshlets)
+		*meshlets = std::move(generated_meshlets);
+	return VAO(positions, normals, uvs, indices, vertex_format, primitive_type, bounds);
+}
+
+/* OpenGL Utility Functions */
+
+GLuint CreateShaderFromSource(const GLenum& shader_type, const GLchar * source);
+
+GLuint CreateProgramFromSources(const GLchar * vertex_shader_source, const GLchar * fragment_shader_source);
+
+// Needs compute shader support, GL 4.3 or GL_ARB_compute_shader
+GLuint CreateComputeProgramFromSource(const GLchar * compute_shader_source);
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "opengl_utilities.h"
+
+/*
+	Small fixed meshes evaluated entirely at compile time. Declare them as static constexpr and the vertex and
+	index arrays land in read-only data, nothing is generated or allocated at runtime. Every face winds counter
+	clockwise seen from outside. The arrays are plain floats, since glm's constructors aren't constexpr here.
+*/
+
+/* Compile-time Math */
+constexpr double ConstexprSin(double x)
+{
+	// Reduced to [-PI, PI], where 12 Taylor terms are accurate to about 1e-13
+	constexpr double two_pi = 6.28318530717958647692;
+	auto turns = x / two_pi;
+	x -= double(static_cast<long long>(turns + (turns < 0 ? -0.5 : 0.5))) * two_pi;
+
+	auto term = x;
+	auto sum = x;
+	for (int n = 1; n < 12; ++n)
+	{
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double ConstexprCos(double x)
+{
+	return ConstexprSin(x + 1.57079632679489661923);
+}
+
+/* Primitive Meshes */
+template <int VertexCount, int IndexCount>
+struct PrimitiveMesh
+{
+	static constexpr int vertex_count = VertexCount;
+	static constexpr int index_count = IndexCount;
+
+	float positions[VertexCount][3];
+	float normals[VertexCount][3];
+	float uvs[VertexCount][2];
+	GLuint indices[IndexCount];
+};
+
+template <int VertexCount, int IndexCount>
+constexpr void SetPrimitiveVertex(
+	PrimitiveMesh<VertexCount, IndexCount>& mesh,
+	int i,
+	float x, float y, float z,
+	float normal_x, float normal_y, float normal_z,
+	float u, float v
+)
+{
+	mesh.positions[i][0] = x;
+	mesh.positions[i][1] = y;
+	mesh.positions[i][2] = z;
+	mesh.normals[i][0] = normal_x;
+	mesh.normals[i][1] = normal_y;
+	mesh.normals[i][2] = normal_z;
+	mesh.uvs[i][0] = u;
+	mesh.uvs[i][1] = v;
+}
+
+// Centered box, 4 vertices per face so every face keeps its own normal and full [0, 1] uvs
+constexpr PrimitiveMesh<24, 36> PrimitiveBox(float half_x, float half_y, float half_z)
+{
+	PrimitiveMesh<24, 36> mesh{};
+
+	// Normal, then the face's u and v directions, cross(u, v) == normal
+	const float faces[6][3][3] = {
+		{ { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+		{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+		{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+		{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+		{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+		{ { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } }
+	};
+	const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+	const float half[3] = { half_x, half_y, half_z };
+
+	for (int face = 0; face < 6; ++face)
+	{
+		const auto& n = faces[face][0];
+		const auto& u = faces[face][1];
+		const auto& v = faces[face][2];
+		for (int corner = 0; corner < 4; ++corner)
+		{
+			auto su = corners[corner][0];
+			auto sv = corners[corner][1];
+			float p[3] = {};
+			for (int axis = 0; axis < 3; ++axis)
+				p[axis] = (n[axis] + su * u[axis] + sv * v[axis]) * half[axis];
+			SetPrimitiveVertex(mesh, face * 4 + corner, p[0], p[1], p[2], n[0], n[1], n[2], (su + 1) / 2, (sv + 1) / 2);
+		}
+
+		const GLuint quad[6] = { 0, 1, 2, 0, 2, 3 };
+		for (int i = 0; i < 6; ++i)
+			mesh.indices[face * 6 + i] = GLuint(face * 4) + quad[i];
+	}
+	return mesh;
+}
+
+// Rectangle in the XY plane facing +Z
+constexpr PrimitiveMesh<4, 6> PrimitiveQuad(float half_x, float half_y)
+{
+	PrimitiveMesh<4, 6> mesh{};
+	SetPrimitiveVertex(mesh, 0, -half_x, -half_y, 0, 0, 0, 1, 0, 0);
+	SetPrimitiveVertex(mesh, 1, half_x, -half_y, 0, 0, 0, 1, 1, 0);
+	SetPrimitiveVertex(mesh, 2, half_x, half_y, 0, 0, 0, 1, 1, 1);
+	SetPrimitiveVertex(mesh, 3, -half_x, half_y, 0, 0, 0, 1, 0, 1);
+
+	const GLuint indices[6] = { 0, 1, 2, 0, 2, 3 };
+	for (int i = 0; i < 6; ++i)
+		mesh.indices[i] = indices[i];
+	return mesh;
+}
+
+// Triangle fan in the XY plane facing +Z, the center is vertex 0
+template <int Segments>
+constexpr PrimitiveMesh<Segments + 1, Segments * 3> PrimitiveDisc(float radius)
+{
+	PrimitiveMesh<Segments + 1, Segments * 3> mesh{};
+	SetPrimitiveVertex(mesh, 0, 0, 0, 0, 0, 0, 1, 0.5f, 0.5f);
+	for (int i = 0; i < Segments; ++i)
+	{
+		auto angle = i * 6.28318530717958647692 / Segments;
+		auto c = float(ConstexprCos(angle));
+		auto s = float(ConstexprSin(angle));
+		SetPrimitiveVertex(mesh, i + 1, c * radius, s * radius, 0, 0, 0, 1, c * 0.5f + 0.5f, s * 0.5f + 0.5f);
+
+		mesh.indices[i * 3] = 0;
+		mesh.indices[i * 3 + 1] = GLuint(i + 1);
+		mesh.indices[i * 3 + 2] = GLuint((i + 1) % Segments + 1);
+	}
+	return mesh;
+}
+
+// A circle arc of the given radius around (center_x, 0) in the XY plane, from angle_begin over angle_range,
+// rotated around Y. Same vertex layout and uvs as GenerateParametricShapeFrom2D with a duplicated seam column,
+// but the grid triangles are flipped to the counter clockwise winding of the other primitives.
+template <int VerticalSegments, int RotationSegments>
+constexpr PrimitiveMesh<VerticalSegments * (RotationSegments + 1), (VerticalSegments - 1) * RotationSegments * 6>
+PrimitiveRevolvedArc(float center_x, float radius, double angle_begin, double angle_range)
+{
+	PrimitiveMesh<VerticalSegments * (RotationSegments + 1), (VerticalSegments - 1) * RotationSegments * 6> mesh{};
+	for (int r = 0; r <= RotationSegments; ++r)
+	{
+		auto rotation = r * 6.28318530717958647692 / RotationSegments;
+		auto rotation_cos = ConstexprCos(rotation);
+		auto rotation_sin = ConstexprSin(rotation);
+		for (int v = 0; v < VerticalSegments; ++v)
+		{
+			auto t = v / double(VerticalSegments - 1);
+			auto angle = angle_begin + t * angle_range;
+			auto normal_x = ConstexprCos(angle);
+			auto normal_y = ConstexprSin(angle);
+			auto x = center_x + normal_x * radius;
+
+			// glm::rotateY(p, rotation) is (x * cos, y, -x * sin)
+			SetPrimitiveVertex(mesh, r * VerticalSegments + v,
+				float(x * rotation_cos), float(normal_y * radius), float(-x * rotation_sin),
+				float(normal_x * rotation_cos), float(normal_y), float(-normal_x * rotation_sin),
+				float(r / double(RotationSegments)), float(t));
+		}
+	}
+
+	for (int r = 0; r < RotationSegments; ++r)
+		for (int v = 0; v < VerticalSegments - 1; ++v)
+		{
+			auto quad = (r * (VerticalSegments - 1) + v) * 6;
+			auto index = GLuint(r * VerticalSegments + v);
+			auto next_column = GLuint(VerticalSegments);
+			mesh.indices[quad] = index + 1;
+			mesh.indices[quad + 1] = index;
+			mesh.indices[quad + 2] = index + next_column;
+
+			mesh.indices[quad + 3] = index + 1;
+			mesh.indices[quad + 4] = index + next_column;
+			mesh.indices[quad + 5] = index + next_column + 1;
+		}
+	return mesh;
+}
+
+template <int VerticalSegments, int RotationSegments>
+constexpr auto PrimitiveSphere(float radius)
+	-> decltype(PrimitiveRevolvedArc<VerticalSegments, RotationSegments>(0, 0, 0, 0))
+{
+	return PrimitiveRevolvedArc<VerticalSegments, RotationSegments>(0, radius, -1.57079632679489661923, 3.14159265358979323846);
+}
+
+template <int VerticalSegments, int RotationSegments>
+constexpr auto PrimitiveTorus(float major_radius, float minor_radius)
+	-> decltype(PrimitiveRevolvedArc<VerticalSegments, RotationSegments>(0, 0, 0, 0))
+{
+	return PrimitiveRevolvedArc<VerticalSegments, RotationSegments>(major_radius, minor_radius, -3.14159265358979323846, 6.28318530717958647692);
+}
+
+/* Upload */
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::vec2) == 2 * sizeof(float), "the float arrays are read as glm vectors");
+
+template <int VertexCount, int IndexCount>
+VAO PrimitiveVAO(
+	const PrimitiveMesh<VertexCount, IndexCount>& mesh,
+	VertexFormat vertex_format = VertexFormat::Separate
+)
+{
+	return VAO(
+		reinterpret_cast<const glm::vec3*>(mesh.positions),
+		reinterpret_cast<const glm::vec3*>(mesh.normals),
+		reinterpret_cast<const glm::vec2*>(mesh.uvs),
+		VertexCount,
+		mesh.indices,
+		IndexCount,
+		vertex_format
+	);
+}
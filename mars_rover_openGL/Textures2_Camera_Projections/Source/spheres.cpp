@@ -0,0 +1,481 @@
+#include "spheres.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include "GLM/gtc/constants.hpp"
+
+/* Sphere Builder */
+// Faces compute their shared edge vertices bit for bit the same, so vertices are merged on their exact position
+struct PositionHash
+{
+	size_t operator()(const glm::vec3& position) const
+	{
+		uint32_t bits[3];
+		std::memcpy(bits, &position, sizeof(bits));
+		return size_t(bits[0]) * 73856093u ^ size_t(bits[1]) * 19349663u ^ size_t(bits[2]) * 83492791u;
+	}
+};
+
+struct SphereBuilder
+{
+	std::vector<glm::vec3>& positions;
+	std::vector<glm::vec3>& normals;
+	std::vector<glm::vec2>& uvs;
+	std::vector<GLuint>& indices;
+	float radius;
+	std::unordered_map<glm::vec3, GLuint, PositionHash> vertices;
+
+	SphereBuilder(
+		std::vector<glm::vec3>& positions,
+		std::vector<glm::vec3>& normals,
+		std::vector<glm::vec2>& uvs,
+		std::vector<GLuint>& indices,
+		float radius
+	)
+		: positions(positions), normals(normals), uvs(uvs), indices(indices), radius(radius)
+	{
+	}
+
+	// The vertex in direction, of any length, on the sphere
+	GLuint Vertex(const glm::dvec3& direction)
+	{
+		auto unit = glm::normalize(direction);
+		if (std::abs(unit.z) < 1e-12)
+			unit.z = 0;	// Icosahedron points meant for the u = 0 meridian, not a sliver away from it
+		auto normal = glm::vec3(unit) + glm::vec3(0);	// -0 to +0, they hash differently
+		auto found = vertices.find(normal);
+		if (found != vertices.end())
+			return found->second;
+
+		auto u = std::atan2(-unit.z, unit.x) / glm::two_pi<double>();
+		auto v = std::asin(glm::clamp(unit.y, -1., 1.)) / glm::pi<double>() + 0.5;
+		auto index = GLuint(positions.size());
+		positions.push_back(normal * radius);
+		normals.push_back(normal);
+		uvs.push_back(glm::vec2(u < 0 ? u + 1 : u, v));
+		vertices.emplace(normal, index);
+		return index;
+	}
+
+	void Triangle(GLuint a, GLuint b, GLuint c)
+	{
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	}
+};
+
+static bool IsPole(const glm::vec3& normal)
+{
+	return normal.x * normal.x + normal.z * normal.z < 1e-12f;
+}
+
+// On the u = 0 meridian, u could be 0 or 1
+static bool IsOnSeam(const glm::vec3& normal)
+{
+	return normal.z == 0 && normal.x > 0;
+}
+
+// A triangle whose u values are more than half a turn apart crosses u = 0. Instead of letting u run past 1, which
+// the 16 bit uvs of the interleaved VAO formats can't store, such triangles are cut along the meridian, so every
+// u stays in [0, 1] and interpolates without a jump. Vertices on the meridian get a copy with u = 1 for the
+// triangles west of it. A pole vertex takes the u of the rest of its triangle, every triangle but the first gets
+// its own copy.
+static void SplitUVSeam(SphereBuilder& sphere)
+{
+	const auto none = GLuint(-1);
+	std::vector<GLuint> west(sphere.positions.size(), none);
+	std::unordered_map<uint64_t, GLuint> cuts;
+	std::vector<GLuint> indices;
+	indices.reserve(sphere.indices.size() + sphere.indices.size() / 8);
+
+	auto Copy = [&sphere](GLuint index, float u)
+	{
+		auto copy = GLuint(sphere.positions.size());
+		sphere.positions.push_back(sphere.positions[index]);
+		sphere.normals.push_back(sphere.normals[index]);
+		sphere.uvs.push_back(glm::vec2(u, sphere.uvs[index].y));
+		return copy;
+	};
+
+	// -1 east of the meridian (u < 0.5), 1 west of it, 0 on the meridian or a pole
+	auto Side = [&sphere](GLuint index)
+	{
+		const auto& normal = sphere.normals[index];
+		if (IsPole(normal) || IsOnSeam(normal))
+			return 0;
+		return sphere.uvs[index].x < 0.5f ? -1 : 1;
+	};
+
+	auto OnSide = [&](GLuint index, int side)
+	{
+		if (side < 0 || !IsOnSeam(sphere.normals[index]))
+			return index;
+		if (west[index] == none)
+			west[index] = Copy(index, 1);
+		return west[index];
+	};
+
+	// Where the edge crosses the meridian, on the edge itself so the mesh keeps its shape. The east copy has u = 0,
+	// the west one u = 1, both neighbours of the edge compute it from the same ordered endpoints.
+	auto Cut = [&](GLuint a, GLuint b, int side)
+	{
+		if (a > b)
+			std::swap(a, b);
+		auto key = uint64_t(a) << 32 | b;
+		auto found = cuts.find(key);
+		if (found == cuts.end())
+		{
+			auto from = glm::dvec3(sphere.positions[a]), to = glm::dvec3(sphere.positions[b]);
+			auto point = from + (to - from) * (from.z / (from.z - to.z));
+			point.z = 0;
+			auto normal = glm::vec3(glm::normalize(point));
+			auto index = GLuint(sphere.positions.size());
+			sphere.positions.push_back(glm::vec3(point));
+			sphere.normals.push_back(normal);
+			sphere.uvs.push_back(glm::vec2(0, std::asin(glm::clamp(normal.y, -1.f, 1.f)) / glm::pi<float>() + 0.5f));
+			west.resize(sphere.positions.size(), none);
+			found = cuts.emplace(key, index).first;
+		}
+		return OnSide(found->second, side);
+	};
+
+	auto Emit = [&indices](GLuint a, GLuint b, GLuint c)
+	{
+		indices.push_back(a);
+		indices.push_back(b);
+		indices.push_back(c);
+	};
+
+	for (size_t triangle = 0; triangle < sphere.indices.size(); triangle += 3)
+	{
+		GLuint corners[3];
+		int sides[3];
+		auto min_u = 2.f, max_u = -1.f;
+		for (int k = 0; k < 3; ++k)
+		{
+			corners[k] = sphere.indices[triangle + k];
+			sides[k] = Side(corners[k]);
+			if (sides[k] != 0)
+			{
+				min_u = glm::min(min_u, sphere.uvs[corners[k]].x);
+				max_u = glm::max(max_u, sphere.uvs[corners[k]].x);
+			}
+		}
+
+		if (max_u - min_u <= 0.5f)
+		{
+			auto side = max_u > 0.5f ? 1 : -1;
+			Emit(OnSide(corners[0], side), OnSide(corners[1], side), OnSide(corners[2], side));
+			continue;
+		}
+
+		// Rotated so the corner alone on its side, or on the meridian, comes first, keeping the winding
+		auto first = 0;
+		for (int k = 0; k < 3; ++k)
+			if (sides[k] == 0 || (sides[k] != sides[(k + 1) % 3] && sides[(k + 1) % 3] == sides[(k + 2) % 3]))
+				first = k;
+		auto a = corners[first], b = corners[(first + 1) % 3], c = corners[(first + 2) % 3];
+		auto side_a = sides[first], side_b = sides[(first + 1) % 3], side_c = sides[(first + 2) % 3];
+
+		if (side_a == 0)
+		{
+			// b and c on opposite sides, one cut on bc
+			Emit(OnSide(a, side_b), b, Cut(b, c, side_b));
+			Emit(OnSide(a, side_c), Cut(b, c, side_c), c);
+		}
+		else
+		{
+			// A triangle on a's side and a quad on the other
+			Emit(a, Cut(a, b, side_a), Cut(a, c, side_a));
+			Emit(Cut(a, b, side_b), b, c);
+			Emit(Cut(a, b, side_b), c, Cut(a, c, side_b));
+		}
+	}
+	sphere.indices.swap(indices);
+
+	std::vector<bool> pole_used(sphere.positions.size(), false);
+	for (size_t triangle = 0; triangle < sphere.indices.size(); triangle += 3)
+	{
+		auto corners = &sphere.indices[triangle];
+		for (int k = 0; k < 3; ++k)
+		{
+			if (!IsPole(sphere.normals[corners[k]]))
+				continue;
+			auto u = (sphere.uvs[corners[(k + 1) % 3]].x + sphere.uvs[corners[(k + 2) % 3]].x) / 2;
+			if (!pole_used[corners[k]])
+			{
+				pole_used[corners[k]] = true;
+				sphere.uvs[corners[k]].x = u;
+			}
+			else
+				corners[k] = Copy(corners[k], u);
+		}
+	}
+}
+
+static Bounds FinishSphere(SphereBuilder& sphere)
+{
+	SplitUVSeam(sphere);
+	return ComputeBounds(sphere.positions.data(), sphere.positions.size());
+}
+
+/* Sphere Generators */
+// Angle between neighbouring icosahedron vertices, atan(2)
+static const double icosahedron_edge_angle = 1.10714871779409050302;
+
+Bounds GenerateIcosphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	int edge_segments,
+	float radius
+)
+{
+	auto n = glm::max(edge_segments, 1);
+	positions.clear();
+	normals.clear();
+	uvs.clear();
+	indices.clear();
+	positions.reserve(10 * n * n + 2);
+	normals.reserve(10 * n * n + 2);
+	uvs.reserve(10 * n * n + 2);
+	indices.reserve(size_t(60) * n * n);
+	SphereBuilder sphere(positions, normals, uvs, indices, radius);
+
+	// A vertex on each pole and two rings of five at +-atan(1/2), the lower ring half a step further around.
+	// Same direction of rotation as glm::rotateY, so the upper ring starts at u = 0.
+	glm::dvec3 corners[12];
+	corners[0] = glm::dvec3(0, 1, 0);
+	corners[11] = glm::dvec3(0, -1, 0);
+	auto ring_y = 1 / std::sqrt(5.), ring_radius = 2 / std::sqrt(5.);
+	for (int k = 0; k < 5; ++k)
+	{
+		auto upper = k * glm::two_pi<double>() / 5;
+		auto lower = upper + glm::pi<double>() / 5;
+		corners[1 + k] = glm::dvec3(ring_radius * std::cos(upper), ring_y, -ring_radius * std::sin(upper));
+		corners[6 + k] = glm::dvec3(ring_radius * std::cos(lower), -ring_y, -ring_radius * std::sin(lower));
+	}
+
+	int faces[20][3];
+	for (int k = 0; k < 5; ++k)
+	{
+		auto next = (k + 1) % 5;
+		int face[4][3] = {
+			{ 0, 1 + k, 1 + next },
+			{ 1 + k, 6 + k, 1 + next },
+			{ 6 + k, 6 + next, 1 + next },
+			{ 11, 6 + next, 6 + k }
+		};
+		std::memcpy(faces[k * 4], face, sizeof(face));
+	}
+
+	// Points on an icosahedron edge are always interpolated from its lower corner, so both faces get the same bits
+	auto EdgePoint = [&corners, n](int from, int to, int step)
+	{
+		if (from > to)
+		{
+			std::swap(from, to);
+			step = n - step;
+		}
+		if (step == 0)
+			return corners[from];
+		if (step == n)
+			return corners[to];
+		return corners[from] + (corners[to] - corners[from]) * (step / double(n));
+	};
+
+	std::vector<GLuint> grid((n + 1) * (n + 2) / 2);
+	for (const auto& face : faces)
+	{
+		const auto& a = corners[face[0]];
+		const auto& b = corners[face[1]];
+		const auto& c = corners[face[2]];
+
+		// Triangular grid, i steps from a to b and j from a to c
+		auto GridIndex = [n](int i, int j) { return j * (n + 1) - j * (j - 1) / 2 + i; };
+		for (int j = 0; j <= n; ++j)
+			for (int i = 0; i + j <= n; ++i)
+			{
+				glm::dvec3 point;
+				if (j == 0)
+					point = EdgePoint(face[0], face[1], i);
+				else if (i == 0)
+					point = EdgePoint(face[0], face[2], j);
+				else if (i + j == n)
+					point = EdgePoint(face[1], face[2], j);
+				else
+					point = a + (b - a) * (i / double(n)) + (c - a) * (j / double(n));
+				grid[GridIndex(i, j)] = sphere.Vertex(point);
+			}
+
+		for (int j = 0; j < n; ++j)
+			for (int i = 0; i + j < n; ++i)
+			{
+				sphere.Triangle(grid[GridIndex(i, j)], grid[GridIndex(i + 1, j)], grid[GridIndex(i, j + 1)]);
+				if (i + j + 1 < n)
+					sphere.Triangle(grid[GridIndex(i + 1, j)], grid[GridIndex(i + 1, j + 1)], grid[GridIndex(i, j + 1)]);
+			}
+	}
+	return FinishSphere(sphere);
+}
+
+// Normal, then the face's u and v directions, cross(u, v) == normal
+static const glm::dvec3 cube_faces[6][3] = {
+	{ { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+	{ { -1, 0, 0 }, { 0, 0, 1 }, { 0, 1, 0 } },
+	{ { 0, 1, 0 }, { 1, 0, 0 }, { 0, 0, -1 } },
+	{ { 0, -1, 0 }, { 1, 0, 0 }, { 0, 0, 1 } },
+	{ { 0, 0, 1 }, { 1, 0, 0 }, { 0, 1, 0 } },
+	{ { 0, 0, -1 }, { -1, 0, 0 }, { 0, 1, 0 } }
+};
+
+// Equal angles instead of equal steps on the cube face, the cells in the face centers would be 1.4 times
+// larger than the ones in the corners otherwise. Mirrored and exactly 1 on the edges, so faces agree on the bits.
+// Past the edges the face's plane goes on, for the aprons of terrain chunks.
+static double EqualAngleStep(double a)
+{
+	if (std::abs(a) == 1)
+		return a;
+	auto step = std::tan(std::abs(a) * glm::quarter_pi<double>());
+	return a < 0 ? -step : step;
+}
+
+glm::dvec3 CubeSphereDirection(int face, double a, double b)
+{
+	const auto& axes = cube_faces[face];
+	return glm::normalize(axes[0] + axes[1] * EqualAngleStep(a) + axes[2] * EqualAngleStep(b));
+}
+
+Bounds GenerateCubeSphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	int edge_segments,
+	float radius
+)
+{
+	auto n = glm::max(edge_segments + edge_segments % 2, 2);
+	positions.clear();
+	normals.clear();
+	uvs.clear();
+	indices.clear();
+	positions.reserve(6 * n * n + 2);
+	normals.reserve(6 * n * n + 2);
+	uvs.reserve(6 * n * n + 2);
+	indices.reserve(size_t(36) * n * n);
+	SphereBuilder sphere(positions, normals, uvs, indices, radius);
+
+	std::vector<double> steps(n + 1);
+	for (int i = 0; i <= n; ++i)
+		steps[i] = EqualAngleStep(2. * i / n - 1);
+
+	std::vector<GLuint> grid((n + 1) * (n + 1));
+	for (const auto& face : cube_faces)
+	{
+		for (int j = 0; j <= n; ++j)
+			for (int i = 0; i <= n; ++i)
+				grid[j * (n + 1) + i] = sphere.Vertex(face[0] + face[1] * steps[i] + face[2] * steps[j]);
+
+		for (int j = 0; j < n; ++j)
+			for (int i = 0; i < n; ++i)
+			{
+				auto corner = j * (n + 1) + i;
+				sphere.Triangle(grid[corner], grid[corner + 1], grid[corner + n + 2]);
+				sphere.Triangle(grid[corner], grid[corner + n + 2], grid[corner + n + 1]);
+			}
+	}
+	return FinishSphere(sphere);
+}
+
+Bounds GenerateSphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	SphereTessellation tessellation,
+	int edge_segments,
+	float radius
+)
+{
+	if (tessellation == SphereTessellation::Icosphere)
+		return GenerateIcosphere(positions, normals, uvs, indices, edge_segments, radius);
+	return GenerateCubeSphere(positions, normals, uvs, indices, edge_segments, radius);
+}
+
+int SphereEquatorSegments(SphereTessellation tessellation, int edge_segments)
+{
+	// A full turn in edges of the mesh's edge angle
+	if (tessellation == SphereTessellation::Icosphere)
+		return int(glm::two_pi<double>() / icosahedron_edge_angle * glm::max(edge_segments, 1));
+	return 4 * glm::max(edge_segments + edge_segments % 2, 2);
+}
+
+/* Sphere Error */
+// Ericson, Real-Time Collision Detection 5.1.5
+static glm::dvec3 ClosestPointOnTriangle(const glm::dvec3& p, const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c)
+{
+	auto ab = b - a, ac = c - a, ap = p - a;
+	auto d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+	if (d1 <= 0 && d2 <= 0)
+		return a;
+
+	auto bp = p - b;
+	auto d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+	if (d3 >= 0 && d4 <= d3)
+		return b;
+
+	auto vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return a + ab * (d1 / (d1 - d3));
+
+	auto cp = p - c;
+	auto d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+	if (d6 >= 0 && d5 <= d6)
+		return c;
+
+	auto vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return a + ac * (d2 / (d2 - d6));
+
+	auto va = d3 * d6 - d5 * d4;
+	if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	auto denominator = 1 / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+double MaxSphereDeviation(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, double radius)
+{
+	auto deviation = 0.;
+	for (const auto& position : positions)
+		deviation = glm::max(deviation, std::abs(glm::length(glm::dvec3(position)) - radius));
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		auto closest = ClosestPointOnTriangle(glm::dvec3(0),
+			glm::dvec3(positions[indices[i]]), glm::dvec3(positions[indices[i + 1]]), glm::dvec3(positions[indices[i + 2]]));
+		deviation = glm::max(deviation, radius - glm::length(closest));
+	}
+	return deviation;
+}
+
+size_t CountNonDegenerateTriangles(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices)
+{
+	size_t count = 0;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		// The pole rows of a surface of revolution are a few ulps wide, not exactly collapsed
+		auto ab = glm::dvec3(positions[indices[i + 1]]) - glm::dvec3(positions[indices[i]]);
+		auto ac = glm::dvec3(positions[indices[i + 2]]) - glm::dvec3(positions[indices[i]]);
+		if (glm::length(glm::cross(ab, ac)) > 1e-9 * (glm::dot(ab, ab) + glm::dot(ac, ac)))
+			++count;
+	}
+	return count;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "bounds.h"
+
+/*
+	Spheres without the pole clustering of a surface of revolution, for the same error they need a fraction of
+	the triangles. Both are GL_TRIANGLES, counter clockwise seen from outside, normals point away from the center.
+	The uvs are the equirectangular mapping of GenerateParametricShapeFrom2D(ParametricHalfCircle): u goes once
+	around Y starting at +X, v from the south to the north pole. Triangles across the u = 0 meridian are cut along
+	it, so u stays in [0, 1] and fits the 16 bit uvs of every VertexFormat. Pole vertices get a copy per triangle.
+*/
+
+/* Sphere Generators */
+enum class SphereTessellation
+{
+	Icosphere,	// Every face of an icosahedron split into edge_segments^2 triangles
+	CubeSphere	// Every face of a cube split into edge_segments^2 quads, equal angle spacing
+};
+
+// Like generator_revision, for the sphere generators
+constexpr uint32_t sphere_generator_revision = 1;
+
+// edge_segments splits every edge of the icosahedron
+Bounds GenerateIcosphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	int edge_segments,
+	float radius = 1
+);
+
+// edge_segments splits every edge of the cube, odd counts are rounded up so a vertex sits on each pole
+Bounds GenerateCubeSphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	int edge_segments,
+	float radius = 1
+);
+
+// Unit direction through (a, b) in [-1, 1]^2 on a face of GenerateCubeSphere, with the same spacing. The faces are
+// +X, -X, +Y, -Y, +Z, -Z, a and b run along the face's u and v directions, cross(u, v) is the face normal. Points
+// on an edge shared by two faces come out bit for bit the same from both. Outside [-1, 1] the face's plane extends
+// past its edges.
+glm::dvec3 CubeSphereDirection(int face, double a, double b);
+
+Bounds GenerateSphere(
+	std::vector<glm::vec3>& positions,
+	std::vector<glm::vec3>& normals,
+	std::vector<glm::vec2>& uvs,
+	std::vector<GLuint>& indices,
+	SphereTessellation tessellation,
+	int edge_segments,
+	float radius = 1
+);
+
+// Edges around the equator, what a rotation segment count is for a surface of revolution
+int SphereEquatorSegments(SphereTessellation tessellation, int edge_segments);
+
+/* Sphere Error */
+// Largest distance between a GL_TRIANGLES mesh and the sphere of radius around the origin it approximates.
+// For vertices on the sphere that is where a triangle comes closest to the center.
+double MaxSphereDeviation(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices, double radius = 1);
+
+// Triangles whose area isn't negligible next to their edges, what a sphere of revolution draws without its poles
+size_t CountNonDegenerateTriangles(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices);
@@ -0,0 +1,508 @@
+#include "terrain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include "GLM/gtc/constants.hpp"
+
+#include "spheres.h"
+
+/* Chunk Keys */
+// The quadtrees start with every face split once. The u = 0 meridian runs along the middle of +X, +Y and -Y and
+// the poles sit in the middle of +Y and -Y, so no chunk straddles the uv seam and the poles land on chunk corners.
+static const int root_depth = 1;
+static const int deepest_key_depth = 27;
+
+static uint64_t PackChunkKey(const TerrainChunkKey& key)
+{
+	// 3 bits face, 5 bits depth, 28 bits each for x and y
+	return uint64_t(key.face) << 61 | uint64_t(key.depth) << 56 | uint64_t(key.x) << 28 | uint64_t(key.y);
+}
+
+static TerrainChunkKey UnpackChunkKey(uint64_t packed)
+{
+	const uint64_t mask = (uint64_t(1) << 28) - 1;
+	return TerrainChunkKey{ int(packed >> 61), int(packed >> 56 & 31), uint32_t(packed >> 28 & mask), uint32_t(packed & mask) };
+}
+
+static TerrainChunkKey ParentChunkKey(const TerrainChunkKey& key)
+{
+	return TerrainChunkKey{ key.face, key.depth - 1, key.x / 2, key.y / 2 };
+}
+
+static int ChunkSegments(const TerrainOptions& options)
+{
+	return glm::max(options.chunk_segments + options.chunk_segments % 2, 2);
+}
+
+// Face coordinate in [-1, 1] of grid line i of a chunk. A parent's line and its child's are the same fraction, so
+// they come out with the same bits and the even vertices of a child land exactly on its parent's.
+static double FaceCoordinate(uint32_t chunk, int depth, int i, int segments)
+{
+	return 2. * (double(chunk) * segments + i) / (double(segments) * double(uint64_t(1) << depth)) - 1;
+}
+
+/* Chunk Bounds */
+struct ChunkSphere
+{
+	glm::dvec3 center;
+	double radius;
+};
+
+// Around the chunk's center on the unit sphere, out to its farthest corner. Heights add up to height_scale.
+static ChunkSphere ComputeChunkSphere(const TerrainChunkKey& key)
+{
+	auto size = 2. / double(uint64_t(1) << key.depth);
+	auto a = -1 + key.x * size, b = -1 + key.y * size;
+
+	ChunkSphere sphere{ CubeSphereDirection(key.face, a + size / 2, b + size / 2), 0 };
+	for (int corner = 0; corner < 4; ++corner)
+	{
+		auto direction = CubeSphereDirection(key.face, a + (corner & 1) * size, b + (corner >> 1) * size);
+		sphere.radius = glm::max(sphere.radius, glm::length(direction - sphere.center));
+	}
+	return sphere;
+}
+
+// The unit sphere hides a point at radius r that is more than acos(1 / |camera|) + acos(1 / r) around from the camera
+static bool AboveHorizon(const ChunkSphere& sphere, const glm::dvec3& camera, double max_radius)
+{
+	auto distance = glm::length(camera);
+	if (distance <= 1)
+		return true;
+
+	auto angle = std::acos(glm::clamp(glm::dot(sphere.center, camera) / distance, -1., 1.));
+	auto chunk_angle = 2 * std::asin(glm::min(sphere.radius / 2, 1.));
+	return angle - chunk_angle <= std::acos(1 / distance) + std::acos(1 / max_radius);
+}
+
+/* Chunk Building */
+static glm::vec2 SphereUV(const glm::dvec3& direction)
+{
+	auto u = std::atan2(-direction.z, direction.x) / glm::two_pi<double>();
+	auto v = std::asin(glm::clamp(direction.y, -1., 1.)) / glm::pi<double>() + 0.5;
+	return glm::vec2(u < 0 ? u + 1 : u, v);
+}
+
+static std::vector<GLuint> ChunkIndices(int segments)
+{
+	// Same diagonals as GenerateCubeSphere, from (i, j) to (i + 1, j + 1)
+	std::vector<GLuint> indices;
+	indices.reserve(size_t(6) * segments * segments);
+	for (int j = 0; j < segments; ++j)
+		for (int i = 0; i < segments; ++i)
+		{
+			auto corner = GLuint(j * (segments + 1) + i);
+			auto above = corner + segments + 1;
+			indices.insert(indices.end(), { corner, corner + 1, above + 1, corner, above + 1, above });
+		}
+	return indices;
+}
+
+size_t TerrainChunkMesh::ByteSize() const
+{
+	return positions.size() * sizeof(glm::vec3) + normals.size() * sizeof(glm::vec3) +
+		uvs.size() * sizeof(glm::vec2) + morph_positions.size() * sizeof(glm::vec3);
+}
+
+TerrainChunkMesh BuildTerrainChunkMesh(const TerrainChunkKey& key, const TerrainOptions& options, const Heightmap* heightmap)
+{
+	auto start = std::chrono::steady_clock::now();
+	auto segments = ChunkSegments(options);
+	auto row = segments + 1;
+
+	// The grid and a ring of one vertex around it, off the chunk and past face edges
+	auto apron_row = segments + 3;
+	std::vector<glm::dvec3> directions(apron_row * apron_row);
+	std::vector<glm::vec2> sample_uvs(apron_row * apron_row);
+	for (int j = -1; j <= segments + 1; ++j)
+	{
+		auto b = FaceCoordinate(key.y, key.depth, j, segments);
+		for (int i = -1; i <= segments + 1; ++i)
+		{
+			auto index = (j + 1) * apron_row + i + 1;
+			directions[index] = CubeSphereDirection(key.face, FaceCoordinate(key.x, key.depth, i, segments), b);
+			sample_uvs[index] = SphereUV(directions[index]);
+		}
+	}
+
+	std::vector<float> heights(directions.size(), 0.f);
+	if (heightmap != nullptr)
+		SampleHeightmap(*heightmap, sample_uvs.data(), heights.data(), heights.size());
+
+	std::vector<glm::dvec3> displaced(directions.size());
+	for (size_t i = 0; i < directions.size(); ++i)
+		displaced[i] = directions[i] * (1 + double(heights[i]) * options.height_scale);
+	auto At = [&displaced, apron_row](int i, int j) { return displaced[(j + 1) * apron_row + i + 1]; };
+
+	TerrainChunkMesh mesh;
+	mesh.key = PackChunkKey(key);
+	mesh.positions.resize(row * row);
+	mesh.normals.resize(row * row);
+	mesh.uvs.resize(row * row);
+	mesh.morph_positions.resize(row * row);
+
+	// Seam vertices take u = 1 on chunks west of the meridian, the poles the u of the chunk they are drawn with
+	auto center_u = SphereUV(CubeSphereDirection(key.face,
+		FaceCoordinate(key.x, key.depth, segments / 2, segments), FaceCoordinate(key.y, key.depth, segments / 2, segments))).x;
+
+	for (int j = 0; j <= segments; ++j)
+		for (int i = 0; i <= segments; ++i)
+		{
+			auto index = j * row + i;
+			const auto& direction = directions[(j + 1) * apron_row + i + 1];
+			mesh.positions[index] = glm::vec3(At(i, j));
+			mesh.normals[index] = glm::vec3(glm::normalize(glm::cross(At(i + 1, j) - At(i - 1, j), At(i, j + 1) - At(i, j - 1))));
+
+			mesh.uvs[index] = sample_uvs[(j + 1) * apron_row + i + 1];
+			if (direction.x == 0 && direction.z == 0)
+				mesh.uvs[index].x = center_u;
+			else if (direction.z == 0 && direction.x > 0 && center_u > 0.5f)
+				mesh.uvs[index].x = 1;
+		}
+
+	// Where the parent's grid, every other line of this one, puts each vertex. Odd vertices fall on the middle
+	// of a parent edge or, both odd, of the diagonal of a parent cell.
+	for (int j = 0; j <= segments; ++j)
+		for (int i = 0; i <= segments; ++i)
+		{
+			auto odd_i = i % 2 != 0, odd_j = j % 2 != 0;
+			glm::dvec3 target;
+			if (odd_i && odd_j)
+				target = (At(i - 1, j - 1) + At(i + 1, j + 1)) / 2.;
+			else if (odd_i)
+				target = (At(i - 1, j) + At(i + 1, j)) / 2.;
+			else if (odd_j)
+				target = (At(i, j - 1) + At(i, j + 1)) / 2.;
+			else
+				target = At(i, j);
+			mesh.morph_positions[j * row + i] = glm::vec3(target);
+		}
+
+	mesh.build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return mesh;
+}
+
+static TerrainChunk UploadChunk(const TerrainChunkMesh& mesh, const std::vector<GLuint>& indices)
+{
+	VAO vao(mesh.positions, mesh.normals, mesh.uvs, indices, VertexFormat::Interleaved);
+
+	GLuint morph_buffer;
+	glBindVertexArray(vao.id);
+	glGenBuffers(1, &morph_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, morph_buffer);
+	glBufferData(GL_ARRAY_BUFFER, mesh.morph_positions.size() * sizeof(glm::vec3), mesh.morph_positions.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, static_cast<void *>(0));
+	glEnableVertexAttribArray(3);
+
+	return TerrainChunk{ vao, morph_buffer, vao.ByteSize() + mesh.morph_positions.size() * sizeof(glm::vec3), 0, {} };
+}
+
+static void ReleaseChunk(TerrainChunk& chunk)
+{
+	chunk.vao.Release();
+	glDeleteBuffers(1, &chunk.morph_buffer);
+	chunk.morph_buffer = 0;
+}
+
+/* Chunk Builder */
+// Worker threads taking keys from jobs and leaving meshes in done. The rendering thread replaces jobs every frame
+// with what it misses, so chunks the camera has moved away from are dropped before anyone builds them.
+struct TerrainBuilder
+{
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<uint64_t> jobs;
+	std::unordered_set<uint64_t> busy;	// Being built, or built and waiting in done
+	std::vector<TerrainChunkMesh> done;
+	TerrainOptions options;
+	const Heightmap* heightmap;
+	bool stop = false;
+	std::vector<std::thread> workers;
+
+	TerrainBuilder(const TerrainOptions& options, const Heightmap* heightmap, int thread_count)
+		: options(options), heightmap(heightmap)
+	{
+		for (int i = 0; i < thread_count; ++i)
+			workers.emplace_back([this] { Work(); });
+	}
+
+	~TerrainBuilder()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	void Work()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true)
+		{
+			wake.wait(lock, [this] { return stop || !jobs.empty(); });
+			if (stop)
+				return;
+
+			auto key = jobs.front();
+			jobs.pop_front();
+			busy.insert(key);
+
+			lock.unlock();
+			auto mesh = BuildTerrainChunkMesh(UnpackChunkKey(key), options, heightmap);
+			lock.lock();
+			done.push_back(std::move(mesh));
+		}
+	}
+};
+
+static void AddChunk(Terrain& terrain, const TerrainChunkMesh& mesh)
+{
+	auto found = terrain.chunks.emplace(mesh.key, UploadChunk(mesh, terrain.chunk_indices)).first;
+	terrain.lru.push_front(mesh.key);
+	found->second.lru = terrain.lru.begin();
+	terrain.byte_size += found->second.byte_size;
+	++terrain.built;
+
+	++terrain.built_total;
+	terrain.build_seconds_total += mesh.build_seconds;
+	terrain.mesh_bytes_total += mesh.ByteSize();
+}
+
+/* Chunk Selection */
+struct ChunkSelector
+{
+	Terrain& terrain;
+	int segments;
+	int max_depth;
+	glm::dvec3 camera;
+	Frustum frustum;
+	std::vector<double> split_distances;	// A chunk closer to the camera than that splits into its children
+
+	struct Wanted
+	{
+		TerrainChunkKey key;
+		glm::vec2 morph_range;
+	};
+	std::vector<Wanted> wanted;
+
+	ChunkSelector(Terrain& terrain, int segments, int max_depth, const glm::dvec3& camera, const Frustum& frustum)
+		: terrain(terrain), segments(segments), max_depth(max_depth), camera(camera), frustum(frustum)
+	{
+	}
+
+	// Towards the distance where the parent takes over, the vertices morph onto its surface
+	glm::vec2 MorphRange(int depth) const
+	{
+		if (depth <= root_depth)
+			return glm::vec2(0);
+
+		auto parent_split = float(split_distances[depth - 1]);
+		return glm::vec2(parent_split * terrain.options.morph_start, parent_split);
+	}
+
+	TerrainChunk& Touch(const TerrainChunkKey& key)
+	{
+		auto& chunk = terrain.chunks.at(PackChunkKey(key));
+		terrain.lru.splice(terrain.lru.begin(), terrain.lru, chunk.lru);
+		chunk.last_used_frame = terrain.frame;
+		return chunk;
+	}
+
+	void Draw(const TerrainChunkKey& key, const glm::vec2& morph_range)
+	{
+		auto& chunk = Touch(key);
+		terrain.selection.push_back(TerrainDraw{ &chunk.vao, morph_range });
+		terrain.triangle_count += size_t(chunk.vao.element_array_count / 3);
+		terrain.deepest = glm::max(terrain.deepest, key.depth);
+	}
+
+	// False when the chunk is too far for its depth, its parent covers the area then
+	bool Select(const TerrainChunkKey& key)
+	{
+		auto sphere = ComputeChunkSphere(key);
+		auto radius = sphere.radius + terrain.options.height_scale;
+		if (!AboveHorizon(sphere, camera, 1. + terrain.options.height_scale) ||
+			!SphereInFrustum(frustum, glm::vec3(sphere.center), float(radius)))
+			return true;
+
+		auto distance = glm::length(camera - sphere.center) - radius;
+		if (key.depth > root_depth && distance >= split_distances[key.depth - 1])
+			return false;
+
+		if (key.depth == max_depth || distance >= split_distances[key.depth])
+		{
+			wanted.push_back(Wanted{ key, MorphRange(key.depth) });
+			return true;
+		}
+
+		for (uint32_t child = 0; child < 4; ++child)
+		{
+			TerrainChunkKey child_key{ key.face, key.depth + 1, key.x * 2 + (child & 1), key.y * 2 + (child >> 1) };
+			// Morphed all the way, a child is the quadrant of this chunk it covers
+			if (!Select(child_key))
+				wanted.push_back(Wanted{ child_key, glm::vec2(-1, 0) });
+		}
+		return true;
+	}
+};
+
+/* Terrain */
+void SelectTerrainChunks(
+	Terrain& terrain,
+	const glm::vec3& camera_position,
+	const glm::mat4& projection_view_model,
+	float fov_y,
+	float screen_height
+)
+{
+	const auto& options = terrain.options;
+	ChunkSelector selector(
+		terrain,
+		ChunkSegments(options),
+		glm::clamp(options.max_depth, root_depth, deepest_key_depth),
+		glm::dvec3(camera_position),
+		ExtractFrustum(projection_view_model)
+	);
+
+	// A cell spans a quarter turn over segments * 2^depth, so it projects to at most target_edge_pixels from
+	// split_distance on. At least two chunks across keeps neighbours within a level of each other, which is
+	// what morphing needs to close every crack.
+	auto pixels_per_radian = screen_height / 2 / std::tan(fov_y / 2);
+	for (int depth = 0; depth <= selector.max_depth; ++depth)
+	{
+		auto chunk_angle = glm::half_pi<double>() / double(uint64_t(1) << depth);
+		auto cell_distance = chunk_angle / selector.segments * pixels_per_radian / options.target_edge_pixels;
+		selector.split_distances.push_back(glm::max(cell_distance, 2 * chunk_angle));
+	}
+
+	++terrain.frame;
+	terrain.selection.clear();
+	terrain.triangle_count = 0;
+	terrain.deepest = 0;
+	terrain.built = 0;
+	terrain.stand_ins = 0;
+
+	if (terrain.chunk_indices.empty())
+		terrain.chunk_indices = ChunkIndices(selector.segments);
+	if (!terrain.builder)
+	{
+		auto thread_count = options.build_threads > 0 ? options.build_threads : int(std::thread::hardware_concurrency()) - 1;
+		terrain.builder = std::make_shared<TerrainBuilder>(options, terrain.heightmap, glm::max(thread_count, 1));
+	}
+	auto& builder = *terrain.builder;
+
+	// Finished meshes first, they may be what this frame wants
+	std::vector<TerrainChunkMesh> done;
+	{
+		std::lock_guard<std::mutex> lock(builder.mutex);
+		done.swap(builder.done);
+		for (const auto& mesh : done)
+			builder.busy.erase(mesh.key);
+	}
+	for (const auto& mesh : done)
+		if (terrain.chunks.find(mesh.key) == terrain.chunks.end())
+			AddChunk(terrain, mesh);
+	done.clear();
+
+	for (int face = 0; face < 6; ++face)
+		for (uint32_t root = 0; root < 4; ++root)
+			selector.Select(TerrainChunkKey{ face, root_depth, root & 1, root >> 1 });
+
+	// A missing chunk is queued and its nearest resident ancestor drawn instead. Roots are built right away, so
+	// there always is one.
+	auto Resident = [&terrain](const TerrainChunkKey& key) { return terrain.chunks.count(PackChunkKey(key)) != 0; };
+	std::vector<TerrainChunkKey> missing;
+	std::unordered_set<uint64_t> stand_ins;
+	for (const auto& wanted : selector.wanted)
+	{
+		if (Resident(wanted.key))
+			continue;
+		missing.push_back(wanted.key);
+
+		auto ancestor = wanted.key;
+		while (ancestor.depth > root_depth && !Resident(ancestor))
+			ancestor = ParentChunkKey(ancestor);
+		if (!Resident(ancestor))
+			AddChunk(terrain, BuildTerrainChunkMesh(ancestor, options, terrain.heightmap));
+		if (PackChunkKey(ancestor) != PackChunkKey(wanted.key))
+			stand_ins.insert(PackChunkKey(ancestor));
+	}
+
+	// Stand ins may nest, only the outermost is drawn and whatever it covers isn't
+	auto StoodIn = [&stand_ins](TerrainChunkKey key, bool itself)
+	{
+		if (!itself)
+			key = ParentChunkKey(key);
+		for (; key.depth >= root_depth; key = ParentChunkKey(key))
+			if (stand_ins.count(PackChunkKey(key)) != 0)
+				return true;
+		return false;
+	};
+	// Chunks under a stand in stay cached, evicting them would only queue them again
+	for (const auto& wanted : selector.wanted)
+		if (Resident(wanted.key))
+		{
+			if (StoodIn(wanted.key, true))
+				selector.Touch(wanted.key);
+			else
+				selector.Draw(wanted.key, wanted.morph_range);
+		}
+	for (auto packed : stand_ins)
+	{
+		auto key = UnpackChunkKey(packed);
+		if (!StoodIn(key, false))
+		{
+			selector.Draw(key, selector.MorphRange(key.depth));
+			++terrain.stand_ins;
+		}
+	}
+
+	// Coarse chunks first, they replace the largest stand ins
+	std::stable_sort(missing.begin(), missing.end(),
+		[](const TerrainChunkKey& a, const TerrainChunkKey& b) { return a.depth < b.depth; });
+	{
+		std::lock_guard<std::mutex> lock(builder.mutex);
+		builder.jobs.clear();
+		for (const auto& key : missing)
+		{
+			auto packed = PackChunkKey(key);
+			if (builder.busy.count(packed) == 0)
+				builder.jobs.push_back(packed);
+		}
+		terrain.pending = int(builder.jobs.size() + builder.busy.size());
+	}
+	builder.wake.notify_all();
+
+	// Least recently used first, never what this frame draws
+	while (terrain.byte_size > options.memory_budget && !terrain.lru.empty())
+	{
+		auto found = terrain.chunks.find(terrain.lru.back());
+		if (found->second.last_used_frame == terrain.frame)
+			break;
+
+		terrain.byte_size -= found->second.byte_size;
+		ReleaseChunk(found->second);
+		terrain.chunks.erase(found);
+		terrain.lru.pop_back();
+	}
+}
+
+void ReleaseTerrain(Terrain& terrain)
+{
+	terrain.builder.reset();
+	for (auto& chunk : terrain.chunks)
+		ReleaseChunk(chunk.second);
+	terrain.chunks.clear();
+	terrain.lru.clear();
+	terrain.selection.clear();
+	terrain.byte_size = 0;
+}
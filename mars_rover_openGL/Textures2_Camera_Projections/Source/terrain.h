@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "GLM/glm.hpp"
+#include "GLAD/glad.h"
+
+#include "heightmap.h"
+#include "opengl_utilities.h"
+
+/*
+	Chunked LOD terrain on the unit cube sphere, CDLOD style. Every face is a quadtree whose nodes are chunks of
+	the same grid, a node splits while the camera is close enough that its cells would project larger than
+	target_edge_pixels. Towards the distance where their parent takes over, chunk vertices morph onto the
+	parent's coarser surface in the vertex shader, so levels blend without popping and neighbours of different
+	levels meet without cracks. Chunks are built on demand and kept in an LRU cache within memory_budget bytes.
+
+	A heightmap displaces the surface outwards by up to height_scale. Worker threads build the chunk meshes, the
+	rendering thread only uploads them. Until a chunk arrives its nearest resident ancestor is drawn in its place.
+
+	The vertex shader reads the morph target from attribute 3 and morphs with
+		mix(a_position, a_morph_position, clamp((distance(a_position, camera) - range.x) / (range.y - range.x), 0, 1))
+	where range is TerrainDraw::morph_range and camera the position passed to SelectTerrainChunks.
+*/
+
+/* Terrain */
+struct TerrainOptions
+{
+	int chunk_segments = 32;			// Grid cells along a chunk edge, even
+	int max_depth = 12;					// Depth 12 cells are 1/131072 of a face edge
+	float target_edge_pixels = 8;
+	float morph_start = 0.7f;			// Fraction of the distance where the parent takes over that morphing starts at
+	size_t memory_budget = 64 << 20;	// Bytes of chunk buffers kept around, chunks of the current frame stay regardless
+	float height_scale = 0.002f;		// Radius the highest texel adds, the lowest one stays on the unit sphere
+	int build_threads = 0;				// 0 for every core but one
+};
+
+struct TerrainChunkKey
+{
+	int face;
+	int depth;
+	uint32_t x;
+	uint32_t y;
+};
+
+// What a worker thread builds, everything but the GL buffers
+struct TerrainChunkMesh
+{
+	uint64_t key;
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> morph_positions;
+	double build_seconds = 0;
+
+	size_t ByteSize() const;
+};
+
+struct TerrainChunk
+{
+	VAO vao;							// Interleaved, positions on the displaced unit sphere
+	GLuint morph_buffer;				// float3 per vertex, where it lies on the parent's surface
+	size_t byte_size;
+	uint64_t last_used_frame;
+	std::list<uint64_t>::iterator lru;	// Position in Terrain::lru
+};
+
+struct TerrainDraw
+{
+	const VAO* vao;
+	glm::vec2 morph_range;				// Distances where morphing starts and ends, (0, 0) for none, (-1, 0) for all the way
+};
+
+struct TerrainBuilder;
+
+struct Terrain
+{
+	TerrainOptions options;
+	const Heightmap* heightmap = nullptr;	// A smooth sphere without one, has to outlive the terrain
+	std::unordered_map<uint64_t, TerrainChunk> chunks;
+	std::list<uint64_t> lru;			// Most recently used first
+	size_t byte_size = 0;
+	uint64_t frame = 0;
+	std::vector<GLuint> chunk_indices;	// Every chunk has the same grid
+	std::shared_ptr<TerrainBuilder> builder;
+
+	// Over every chunk built so far
+	size_t built_total = 0;
+	double build_seconds_total = 0;		// On the worker threads, without the upload
+	size_t mesh_bytes_total = 0;		// Of the CPU side meshes, freed once uploaded
+
+	// Of the last SelectTerrainChunks
+	std::vector<TerrainDraw> selection;
+	size_t triangle_count = 0;
+	int deepest = 0;
+	int built = 0;						// Uploaded
+	int pending = 0;					// Queued or being built
+	int stand_ins = 0;					// Ancestors drawn for chunks that aren't built yet
+};
+
+// Builds a chunk without touching GL, safe to call from any thread. Normals come from central differences over a
+// ring of vertices around the chunk, so chunks agree on them along shared edges.
+TerrainChunkMesh BuildTerrainChunkMesh(const TerrainChunkKey& key, const TerrainOptions& options, const Heightmap* heightmap);
+
+// Picks the chunks for a camera at camera_position, in the space of the unit sphere, uploads the chunks the workers
+// finished, queues the missing ones and evicts the least recently used ones over budget. Chunks behind the horizon or outside the frustum of
+// projection_view_model, which maps the unit sphere to clip space, are skipped.
+void SelectTerrainChunks(
+	Terrain& terrain,
+	const glm::vec3& camera_position,
+	const glm::mat4& projection_view_model,
+	float fov_y,
+	float screen_height
+);
+
+// Stops the workers and deletes every chunk
+void ReleaseTerrain(Terrain& terrain);